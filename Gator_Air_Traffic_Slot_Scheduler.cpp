@@ -1,20 +1,44 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cerrno>
 #include <climits>
+#include <csignal>
+#include <cstring>
 #include <ctime>
+#include <filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "alloc_counter.hpp"
 #include "binary_heap.hpp"
+#include "bucket_queue.hpp"
+#include "copy_on_write.hpp"
+#include "flight_table.hpp"
 #include "pairing_heap.hpp"
+#include "perf_counters.hpp"
+#include "queue_concepts.hpp"
+#include "run_length_set.hpp"
+#include "spsc_ring.hpp"
+#include "thread_pool.hpp"
 
 using namespace std;
 
-// Global output stream for all program output
-stringstream ss;
-
 // Flight lifecycle states
 enum FlightState { PENDING, SCHEDULED, IN_PROGRESS, COMPLETED };
 
@@ -44,22 +68,6 @@ struct PendingFlight {
         flightRequest(flightRequest) {}
 };
 
-// Flight data after scheduling
-struct ActiveFlightData {
-  int runwayId;
-  int startTime;
-  int ETA;
-  FlightRequest flightRequest;
-
-  ActiveFlightData()
-      : runwayId(0), startTime(0), ETA(0), flightRequest(0, 0, 0, 0, 0) {}
-
-  ActiveFlightData(int runwayId, int startTime, int ETA,
-                   FlightRequest flightRequest)
-      : runwayId(runwayId), startTime(startTime), ETA(ETA),
-        flightRequest(flightRequest) {}
-};
-
 // Entry in the time table for tracking completion times
 struct TimeTableEntry {
   int ETA;
@@ -85,21 +93,33 @@ struct CompPendingFlight {
   }
 };
 
+// Extracts the bucket index key of a pending flight
+struct PendingFlightPriority {
+  int operator()(const PendingFlight &flight) const { return flight.priority; }
+};
+
+// Extracts the index key of a time table entry, one entry per flight
+struct TimeTableEntryFlightId {
+  int operator()(const TimeTableEntry &entry) const { return entry.flightId; }
+};
+
 // Handle entry for tracking flight state and references
-struct HandlesEntry {
+template <typename PendingHandle> struct HandlesEntry {
   FlightState state;
-  PairingHeapNode<PendingFlight> *pendingNode;
+  PendingHandle pendingNode;
   int submitTime;
   TimeTableEntry timeTableEntry;
+  // Whether an ETA was ever printed, timeTableEntry then holds the last one
+  bool announced;
 
   HandlesEntry()
       : state(PENDING), pendingNode(nullptr), submitTime(0),
-        timeTableEntry(TimeTableEntry(0, 0, 0)) {}
+        timeTableEntry(TimeTableEntry(0, 0, 0)), announced(false) {}
 
-  HandlesEntry(FlightState state, PairingHeapNode<PendingFlight> *node,
-               int submitTime, TimeTableEntry timeTableEntry)
+  HandlesEntry(FlightState state, PendingHandle node, int submitTime,
+               TimeTableEntry timeTableEntry)
       : state(state), pendingNode(node), submitTime(submitTime),
-        timeTableEntry(timeTableEntry) {}
+        timeTableEntry(timeTableEntry), announced(state == SCHEDULED) {}
 };
 
 // Comparator for time table entries
@@ -112,67 +132,267 @@ struct CompTimeTableEntry {
   }
 };
 
+// Comparator for PrintSchedule lines, (ETA, flightId) pairs
+// Ties on ETA order by the text "[flightId]", as when the lines themselves
+// were compared
+struct CompScheduleEntry {
+  bool operator()(const pair<int, int> &a, const pair<int, int> &b) const {
+    if (a.first != b.first) {
+      return a.first < b.first;
+    }
+    char x[16], y[16];
+    char *xEnd = to_chars(x, x + sizeof(x) - 1, a.second).ptr;
+    char *yEnd = to_chars(y, y + sizeof(y) - 1, b.second).ptr;
+    *xEnd++ = ']';
+    *yEnd++ = ']';
+    return lexicographical_compare(x, xEnd, y, yEnd);
+  }
+};
+
+// Scheduler policies select the queue implementations at compile time
+// PendingQueue orders PendingFlight by CompPendingFlight (max first)
+// RunwayPool orders (nextFreeTime, runwayId) pairs (min first)
+// TimeTable orders TimeTableEntry by CompTimeTableEntry (min first)
+template <typename P>
+concept SchedulerPolicy =
+    AddressablePriorityQueue<typename P::PendingQueue> &&
+    PriorityQueue<typename P::RunwayPool> &&
+    ErasablePriorityQueue<typename P::TimeTable> &&
+    std::same_as<typename P::PendingQueue::value_type, PendingFlight> &&
+    std::same_as<typename P::RunwayPool::value_type, pair<int, int>> &&
+    std::same_as<typename P::TimeTable::value_type, TimeTableEntry>;
+
+// Pairing heap for pending flights, binary heaps for runways and timetable
+struct DefaultSchedulerPolicy {
+  using PendingQueue = PairingHeap<PendingFlight, CompPendingFlight>;
+  using RunwayPool = BinaryHeap<pair<int, int>, less<pair<int, int>>>;
+  using TimeTable = BinaryHeap<TimeTableEntry, CompTimeTableEntry>;
+};
+
+// Pairing heaps everywhere, trading array locality for O(1) pushes
+// The time table is indexed by flight ID so erasing an entry skips the walk
+struct AllPairingSchedulerPolicy {
+  using PendingQueue = PairingHeap<PendingFlight, CompPendingFlight>;
+  using RunwayPool = PairingHeap<pair<int, int>, less<pair<int, int>>>;
+  using TimeTable =
+      PairingHeap<TimeTableEntry, CompTimeTableEntry, TimeTableEntryFlightId>;
+};
+
+// Priority range served by bucket queues, other priorities use a pairing heap
+#ifndef BUCKET_MIN_PRIORITY
+#define BUCKET_MIN_PRIORITY 0
+#endif
+#ifndef BUCKET_MAX_PRIORITY
+#define BUCKET_MAX_PRIORITY 15
+#endif
+
+// Bucket queue for pending flights when priorities come from a small range
+struct BucketSchedulerPolicy {
+  using PendingQueue =
+      BucketQueue<PendingFlight, CompPendingFlight, PendingFlightPriority,
+                  BUCKET_MIN_PRIORITY, BUCKET_MAX_PRIORITY>;
+  using RunwayPool = BinaryHeap<pair<int, int>, less<pair<int, int>>>;
+  using TimeTable = BinaryHeap<TimeTableEntry, CompTimeTableEntry>;
+};
+
+// Hypothetical schedule change evaluated by the what-if API
+// Changes apply at the scheduler's current time
+struct WhatIfCandidate {
+  enum Kind { REPRIORITIZE, ADD_RUNWAYS, GROUND_HOLD, CANCEL };
+  Kind kind;
+  int arg1; // flightId, runway count or airlineLow
+  int arg2; // newPriority or airlineHigh, unused otherwise
+};
+
+// Outcome of one candidate relative to the live schedule
+struct WhatIfResult {
+  // (flightId, ETA change) for scheduled flights whose ETA moved
+  vector<pair<int, int>> etaDeltas;
+  // Scheduled flights that the change removes from the schedule
+  vector<int> removedFlights;
+};
+
+// Kinds of output lines, each formatted by formatOutput
+enum class OutputKind : uint8_t {
+  INVALID_INPUT,           // Initialize with a bad runway count
+  RUNWAYS_AVAILABLE,       // runway count
+  DUPLICATE_FLIGHT,        //
+  LANDED,                  // flightId, ETA
+  SCHEDULED,               // flightId, ETA
+  UPDATED_ETAS_BEGIN,      //
+  UPDATED_ETA,             // flightId, ETA, position in the list
+  UPDATED_ETAS_END,        //
+  NO_FLIGHTS_IN_PERIOD,    //
+  SCHEDULE_ENTRY,          // flightId
+  ACTIVE_ENTRY,            // flightId, airlineId, runwayId, startTime, ETA
+  INVALID_AIRLINE_RANGE,   //
+  GROUNDED,                // airlineLow, airlineHigh
+  INVALID_RUNWAY_COUNT,    //
+  ADDITIONAL_RUNWAYS,      // count
+  FLIGHT_NOT_FOUND,        // flightId
+  CANNOT_REPRIORITIZE,     // flightId
+  PRIORITY_UPDATED,        // flightId, newPriority
+  FLIGHT_DOES_NOT_EXIST,   // flightId
+  CANNOT_CANCEL,           // flightId
+  CANCELED,                // flightId
+  TERMINATED,              //
+  RESET,                   //
+  TEXT,                    // preformatted text
+  END_OF_OUTPUT            // closes a pipelined replay, prints nothing
+};
+
+// One output line as a compact record
+// The scheduler only records events, turning them into text is left to the
+// caller (possibly on another thread)
+struct OutputEvent {
+  OutputKind kind;
+  int args[5];
+  string text; // TEXT events only
+};
+
+// Policy used by main, overridable with -DSCHEDULER_POLICY=<policy>
+#ifndef SCHEDULER_POLICY
+#define SCHEDULER_POLICY DefaultSchedulerPolicy
+#endif
+
+template <SchedulerPolicy Policy = DefaultSchedulerPolicy>
 class GatorAirTrafficSlotScheduler {
 public:
+  using PendingQueue = typename Policy::PendingQueue;
+  using RunwayPool = typename Policy::RunwayPool;
+  using TimeTable = typename Policy::TimeTable;
+  using Handle = HandlesEntry<typename PendingQueue::handle_type>;
+
   // Tracks runways by next available time
   // Ensures flights are assigned to earliest free runway
-  BinaryHeap<pair<int, int>, less<pair<int, int>>> runwayPool;
+  RunwayPool runwayPool;
 
   // Priority queue for new flight requests
   // Orders by priority, submit time, and flight ID
-  PairingHeap<PendingFlight, CompPendingFlight> pendingFlights;
+  PendingQueue pendingFlights;
 
-  // Maps flight ID to active flight data
-  // Enables quick lookup for cancellation and reprioritization
-  unordered_map<int, ActiveFlightData> activeFlights;
+  // Runway, start time, ETA and state of scheduled flights by flight ID
+  // Stored column-wise so tick scans run as SIMD filters
+  FlightTable<FlightRequest> activeFlights;
+
+  // Slots selected by the current activeFlights scan, reused across ticks
+  vector<uint32_t> scanSlots;
+
+  // Unscheduled flights of the current tick with their handles
+  vector<pair<PendingFlight, Handle *>> requeue;
 
   // Sorted list of scheduled flights by completion time
   // Enables efficient completion processing on time advancement
-  BinaryHeap<TimeTableEntry, CompTimeTableEntry> timeTable;
+  TimeTable timeTable;
 
   // Groups flights by airline for unsatisfied flights
   // Supports efficient airline-wide operations
-  unordered_map<int, unordered_set<int>> airlineIndex;
+  // Shared with snapshots and what-if forks until written
+  CopyOnWrite<unordered_map<int, unordered_set<int>>> airlineIndex;
 
   // Central map storing references to flight locations
   // Ensures quick and consistent updates across data structures
-  unordered_map<int, HandlesEntry> handles;
+  // Holds live flights only, completed flights move to retiredFlights
+  unordered_map<int, Handle> handles;
+
+  // IDs of completed flights as runs of consecutive IDs
+  // Keeps duplicate detection working without a handle per landed flight
+  // Shared with snapshots and what-if forks until written
+  CopyOnWrite<RunLengthSet> retiredFlights;
 
   int currentTime;
 
+  // Whether Initialize() has provided runways since the last reset
+  bool initialized = false;
+
+  // Lookahead window in minutes, -1 schedules every pending flight
+  // Flights starting after currentTime + horizon stay pending (the backlog)
+  int horizon = -1;
+
+  // Output of the commands run since the caller last drained it
+  vector<OutputEvent> output;
+
+  // Hardware counter totals per tick phase, null unless --perf-stats
+  PerfStats *perfStats = nullptr;
+
+  // Immutable copy of the scheduler state between commands
+  // Pending flights are stored by value since queue handles are not copyable
+  struct Snapshot {
+    int currentTime;
+    int horizon;
+    int runwayCount;
+    FlightTable<FlightRequest> activeFlights;
+    CopyOnWrite<unordered_map<int, unordered_set<int>>> airlineIndex;
+    unordered_map<int, Handle> handles;
+    CopyOnWrite<RunLengthSet> retiredFlights;
+    vector<PendingFlight> pending;
+  };
+
+  // Record an output line
+  void emit(OutputKind kind, int a = 0, int b = 0, int c = 0, int d = 0,
+            int e = 0) {
+    output.push_back({kind, {a, b, c, d, e}, {}});
+  }
+
+  // Record preformatted output, including its line breaks
+  void emitText(string text) {
+    output.push_back({OutputKind::TEXT, {}, std::move(text)});
+  }
+
   // Initialize the system with specified number of runways
   void initialize(int runwayCount) {
     if (runwayCount <= 0) {
-      ss << "Invalid input" << "\n";
+      emit(OutputKind::INVALID_INPUT);
     }
     for (int i = 0; i < runwayCount; i++) {
       runwayPool.push({0, i + 1});
     }
+    initialized = runwayCount > 0;
     currentTime = 0;
-    ss << runwayCount << " Runways are now available" << "\n";
+    emit(OutputKind::RUNWAYS_AVAILABLE, runwayCount);
   }
 
   // Submit a new flight request to the system
   void submitFlight(int flightId, int airlineId, int submitTime, int priority,
                     int duration) {
     tick(submitTime);
-    if (handles.count(flightId)) {
-      ss << "Duplicate FlightID" << "\n";
+    if (handles.count(flightId) || retiredFlights->contains(flightId)) {
+      emit(OutputKind::DUPLICATE_FLIGHT);
       return;
     }
 
     auto pendingFlightHeapNode = pendingFlights.push(PendingFlight(
         priority, submitTime, flightId,
         FlightRequest(flightId, airlineId, submitTime, priority, duration)));
-    airlineIndex[airlineId].insert(flightId);
-    handles[flightId] = HandlesEntry(PENDING, pendingFlightHeapNode, submitTime,
-                                     TimeTableEntry(0, 0, 0));
+    airlineIndex.write()[airlineId].insert(flightId);
+    handles[flightId] = Handle(PENDING, pendingFlightHeapNode, submitTime,
+                               TimeTableEntry(0, 0, 0));
 
     tick(submitTime);
   }
 
+  // Mark flights with start time at or before current time as in progress
+  // These flights are non-preemptive and excluded from rescheduling
+  void promoteStarted() {
+    activeFlights.select({SCHEDULED, INT_MIN, currentTime}, scanSlots);
+    for (uint32_t slot : scanSlots) {
+      int flightId = activeFlights.id(slot);
+      activeFlights.state(slot) = IN_PROGRESS;
+      handles[flightId].state = IN_PROGRESS;
+      unindexAirline(activeFlights.request(slot).airlineId, flightId);
+    }
+  }
+
   // Advance system time and process completions and rescheduling
   void tick(int currentTime) {
+    PerfPhase phase(perfStats, "tick.settle", handles.size());
+    // Catch the previous plan up with the clock first: backlog flights that
+    // would have started by the new time take their planned slots
+    if (currentTime > horizonEnd() && !pendingFlights.empty()) {
+      unordered_map<int, int> rescheduleETAChanged;
+      schedulePending(currentTime, rescheduleETAChanged);
+      printUpdatedETAs(rescheduleETAChanged);
+    }
     this->currentTime = currentTime;
 
     // Phase 1: Settle completions
@@ -191,58 +411,70 @@ public:
     while (!timeTable.empty() && timeTable.top().ETA <= currentTime) {
       int flightId = timeTable.top().flightId;
       completed.push({timeTable.top().ETA, flightId});
-      int airlineId = activeFlights[flightId].flightRequest.airlineId;
-      airlineIndex[airlineId].erase(flightId);
+      size_t slot = activeFlights.find(flightId);
+      unindexAirline(activeFlights.request(slot).airlineId, flightId);
       activeFlights.erase(flightId);
-      handles[flightId].state = COMPLETED;
+      handles.erase(flightId);
+      retiredFlights.write().insert(flightId);
       timeTable.pop();
     }
 
     // Print completed flights in ascending order
     while (!completed.empty()) {
-      ss << "Flight " << completed.top().second << " has landed at time "
-         << completed.top().first << "\n";
+      emit(OutputKind::LANDED, completed.top().second, completed.top().first);
       completed.pop();
     }
 
     // Promotion step between phases
-    // Mark flights with start time at or before current time as in progress
-    // These flights are non-preemptive and excluded from rescheduling
-    for (auto it = activeFlights.begin(); it != activeFlights.end(); it++) {
-      if (it->second.startTime <= currentTime) {
-        handles[it->first].state = IN_PROGRESS;
-        airlineIndex[it->second.flightRequest.airlineId].erase(it->first);
-      }
-    }
+    phase.next("tick.promote", handles.size());
+    promoteStarted();
 
     // Phase 2: Reschedule unsatisfied flights
+    phase.next("tick.unschedule", handles.size());
     // Track runways currently in use
     unordered_map<int, int> inUseRunways;
     // Track flights whose ETA changed during rescheduling
     unordered_map<int, int> rescheduleETAChanged;
     // Convert all scheduled flights back to pending for rescheduling
-    for (auto it = activeFlights.begin(); it != activeFlights.end(); it++) {
-      auto &e = (*it);
-      // Unschedule flights that are scheduled but not yet in progress
-      if (handles[e.first].state == SCHEDULED) {
-        handles[e.first].pendingNode = pendingFlights.push(PendingFlight(
-            e.second.flightRequest.priority, handles[e.first].submitTime,
-            e.first, e.second.flightRequest));
-        handles[e.first].state = PENDING;
-        rescheduleETAChanged[e.first] = e.second.ETA;
-        timeTable.eraseOne(handles[e.first].timeTableEntry);
-        // Unset scheduling fields but keep in active flights
-        e.second.startTime = -1;
-        e.second.ETA = -1;
-        e.second.runwayId = -1;
-      }
-      // Track runways being used by in-progress flights
-      else if (handles[e.first].state == IN_PROGRESS) {
-        inUseRunways[e.second.runwayId] = e.second.ETA;
-      }
+    // Unschedule flights that are scheduled but not yet in progress
+    activeFlights.select({SCHEDULED}, scanSlots);
+    requeue.clear();
+    for (uint32_t slot : scanSlots) {
+      int flightId = activeFlights.id(slot);
+      const FlightRequest &request = activeFlights.request(slot);
+      Handle &handle = handles[flightId];
+      requeue.emplace_back(PendingFlight(request.priority, handle.submitTime,
+                                         flightId, request),
+                           &handle);
+      handle.state = PENDING;
+      activeFlights.state(slot) = PENDING;
+      rescheduleETAChanged[flightId] = activeFlights.ETA(slot);
+      timeTable.eraseOne(handle.timeTableEntry);
+      // Unset scheduling fields but keep in active flights
+      activeFlights.startTime(slot) = -1;
+      activeFlights.ETA(slot) = -1;
+      activeFlights.runwayId(slot) = -1;
+    }
+    // Slot order is scrambled by erases, push in (submitTime, flightId)
+    // order so each priority level of a bucket queue receives its flights
+    // already sorted; heaps take pushes in any order
+    if constexpr (PrefersOrderedPushes<PendingQueue>) {
+      sort(requeue.begin(), requeue.end(), [](const auto &a, const auto &b) {
+        if (a.first.submitTime != b.first.submitTime)
+          return a.first.submitTime < b.first.submitTime;
+        return a.first.flightId < b.first.flightId;
+      });
+    }
+    for (auto &[flight, handle] : requeue)
+      handle->pendingNode = pendingFlights.push(flight);
+    // Track runways being used by in-progress flights
+    activeFlights.select({IN_PROGRESS}, scanSlots);
+    for (uint32_t slot : scanSlots) {
+      inUseRunways[activeFlights.runwayId(slot)] = activeFlights.ETA(slot);
     }
 
     // Rebuild runway pool with current availability
+    phase.next("tick.runways", handles.size());
     int runwayCount = runwayPool.size();
     runwayPool.clear();
     for (int i = 0; i < runwayCount; i++) {
@@ -254,8 +486,31 @@ public:
       }
     }
 
-    // Schedule all pending flights
+    // Schedule pending flights, up to the lookahead horizon if one is set
+    phase.next("tick.schedule", handles.size());
+    schedulePending(horizonEnd(), rescheduleETAChanged);
+    phase.next("tick.report", handles.size());
+    printUpdatedETAs(rescheduleETAChanged);
+  }
+
+  // Latest start time that gets a concrete assignment
+  int horizonEnd() const {
+    if (horizon < 0 || horizon > INT_MAX - currentTime) {
+      return INT_MAX;
+    }
+    return currentTime + horizon;
+  }
+
+  // Greedily assign runways to pending flights starting by horizonEnd
+  // Runway availability only grows as flights are assigned, so stopping at
+  // the first start past horizonEnd leaves the same assignments as a full
+  // pass; the rest stay pending as the backlog
+  void schedulePending(int horizonEnd,
+                       unordered_map<int, int> &rescheduleETAChanged) {
     while (!pendingFlights.empty()) {
+      if (max(currentTime, runwayPool.top().first) > horizonEnd) {
+        break;
+      }
       auto pendingFlight = pendingFlights.pop();
       auto runway = runwayPool.pop();
       int startTime = max(currentTime, runway.first);
@@ -263,102 +518,150 @@ public:
       // Return runway to pool with updated availability
       runwayPool.push({ETA, runway.second});
 
+      // Flights coming back from the backlog compare against their last ETA
+      Handle &handle = handles[pendingFlight.flightId];
+      if (handle.announced &&
+          !rescheduleETAChanged.count(pendingFlight.flightId)) {
+        rescheduleETAChanged[pendingFlight.flightId] =
+            handle.timeTableEntry.ETA;
+      }
+
       // Add flight to time table and active flights
       auto timeTableEntry =
           TimeTableEntry(ETA, pendingFlight.flightId, runway.second);
       timeTable.push(timeTableEntry);
 
-      activeFlights[pendingFlight.flightId] = ActiveFlightData(
-          runway.second, startTime, ETA, pendingFlight.flightRequest);
-      handles[pendingFlight.flightId] = HandlesEntry(
-          SCHEDULED, nullptr, pendingFlight.submitTime, timeTableEntry);
+      activeFlights.assign(pendingFlight.flightId, runway.second, startTime,
+                           ETA, SCHEDULED, pendingFlight.flightRequest);
+      handle = Handle(SCHEDULED, nullptr, pendingFlight.submitTime,
+                      timeTableEntry);
 
       // Track ETA changes or mark as new scheduling
       if (rescheduleETAChanged.count(pendingFlight.flightId) &&
           rescheduleETAChanged[pendingFlight.flightId] != ETA) {
         rescheduleETAChanged[pendingFlight.flightId] = ETA;
       } else if (!rescheduleETAChanged.count(pendingFlight.flightId)) {
-        ss << "Flight " << pendingFlight.flightId << " scheduled - ETA: " << ETA
-           << "\n";
+        emit(OutputKind::SCHEDULED, pendingFlight.flightId, ETA);
       } else {
         rescheduleETAChanged.erase(pendingFlight.flightId);
       }
     }
 
-    // Print rescheduled flights with updated ETAs
+    // Unscheduled flights left in the backlog drop out of active flights
+    // until they are scheduled again, their ETA is not reported as changed
+    if (pendingFlights.empty()) {
+      return;
+    }
+    for (auto it = rescheduleETAChanged.begin();
+         it != rescheduleETAChanged.end();) {
+      if (handles[it->first].state == PENDING) {
+        activeFlights.erase(it->first);
+        it = rescheduleETAChanged.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+
+  // Print rescheduled flights with updated ETAs
+  void printUpdatedETAs(const unordered_map<int, int> &rescheduleETAChanged) {
     BinaryHeap<pair<int, int>, less<pair<int, int>>> rescheduled;
     for (const auto &entry : rescheduleETAChanged) {
       rescheduled.push({entry.first, entry.second});
     }
     if (!rescheduled.empty()) {
-      ss << "Updated ETAs: [";
-      bool first = true;
-      while (!rescheduled.empty()) {
+      emit(OutputKind::UPDATED_ETAS_BEGIN);
+      for (int position = 0; !rescheduled.empty(); position++) {
         auto entry = rescheduled.pop();
-        if (!first) {
-          ss << ", ";
-        }
-        ss << entry.first << ": " << entry.second;
-        first = false;
+        emit(OutputKind::UPDATED_ETA, entry.first, entry.second, position);
       }
-      ss << "]" << "\n";
+      emit(OutputKind::UPDATED_ETAS_END);
     }
   }
 
   // Print all scheduled flights within a time range
   void printSchedule(int t1, int t2) {
-    PairingHeap<pair<int, string>, less<pair<int, string>>> schedulePrintHeap;
-    for (const auto &entry : activeFlights) {
-      if (handles[entry.first].state != SCHEDULED ||
-          entry.second.startTime <= currentTime) {
-        continue;
-      }
-      const ActiveFlightData &data = entry.second;
-      if (data.ETA >= t1 && data.ETA <= t2) {
-        schedulePrintHeap.push({data.ETA, "[" + to_string(entry.first) + "]"});
-      }
+    // Materialize backlog flights that may land within the requested range
+    if (t2 > horizonEnd() && !pendingFlights.empty()) {
+      unordered_map<int, int> rescheduleETAChanged;
+      schedulePending(t2, rescheduleETAChanged);
+      printUpdatedETAs(rescheduleETAChanged);
+    }
+
+    // Scheduled flights that have not started, landing within [t1, t2]
+    PairingHeap<pair<int, int>, CompScheduleEntry> schedulePrintHeap;
+    if (currentTime < INT_MAX) {
+      activeFlights.select({SCHEDULED, currentTime + 1, INT_MAX, t1, t2},
+                           scanSlots);
+    } else {
+      scanSlots.clear();
+    }
+    for (uint32_t slot : scanSlots) {
+      schedulePrintHeap.push({activeFlights.ETA(slot), activeFlights.id(slot)});
     }
 
     if (schedulePrintHeap.empty()) {
-      ss << "There are no flights in that time period" << "\n";
+      emit(OutputKind::NO_FLIGHTS_IN_PERIOD);
     }
 
     while (!schedulePrintHeap.empty()) {
-      ss << schedulePrintHeap.pop().second << "\n";
+      emit(OutputKind::SCHEDULE_ENTRY, schedulePrintHeap.pop().second);
     }
   }
 
   // Print all active flights
   void printActive() {
-    PairingHeap<pair<int, string>, less<pair<int, string>>> activePrintHeap;
-    for (const auto &entry : activeFlights) {
-      const ActiveFlightData &data = entry.second;
-      activePrintHeap.push(
-          {entry.first, "[flight" + to_string(entry.first) + ", airline" +
-                            to_string(data.flightRequest.airlineId) +
-                            ", runway" + to_string(data.runwayId) + ", start" +
-                            to_string(data.startTime) + ", ETA" +
-                            to_string(data.ETA) + "]"});
+    // (flightId, activeFlights slot), slot -1 for backlog flights
+    PairingHeap<pair<int, int>, less<pair<int, int>>> activePrintHeap;
+    for (size_t slot = 0; slot < activeFlights.size(); slot++) {
+      activePrintHeap.push({activeFlights.id(slot), static_cast<int>(slot)});
+    }
+    // Backlog flights beyond the horizon have no runway or times yet
+    if (!pendingFlights.empty()) {
+      for (const auto &entry : handles) {
+        if (entry.second.state != PENDING ||
+            activeFlights.contains(entry.first)) {
+          continue;
+        }
+        activePrintHeap.push({entry.first, -1});
+      }
     }
     while (!activePrintHeap.empty()) {
-      ss << activePrintHeap.top().second << "\n";
-      activePrintHeap.pop();
+      auto [flightId, slot] = activePrintHeap.pop();
+      if (slot >= 0) {
+        emit(OutputKind::ACTIVE_ENTRY, flightId,
+             activeFlights.request(slot).airlineId,
+             activeFlights.runwayId(slot), activeFlights.startTime(slot),
+             activeFlights.ETA(slot));
+      } else {
+        const FlightRequest &request =
+            handles[flightId].pendingNode->value.flightRequest;
+        emit(OutputKind::ACTIVE_ENTRY, flightId, request.airlineId, -1, -1, -1);
+      }
     }
   }
 
   // Ground all flights for airlines in specified range
   void groundHold(int airlineLow, int airlineHigh, int currentTime) {
     tick(currentTime);
+    if (applyGroundHold(airlineLow, airlineHigh)) {
+      tick(currentTime);
+    }
+  }
+
+  // Ground airlines at the current time, returns true if a tick must replan
+  bool applyGroundHold(int airlineLow, int airlineHigh) {
     if (airlineHigh < airlineLow) {
-      ss << "Invalid input. Please provide a valid airline range." << "\n";
-      return;
+      emit(OutputKind::INVALID_AIRLINE_RANGE);
+      return false;
     }
 
     for (int airlineId = airlineLow; airlineId <= airlineHigh; airlineId++) {
-      if (airlineIndex.count(airlineId)) {
+      auto group = airlineIndex->find(airlineId);
+      if (group != airlineIndex->end()) {
         // Copy flight IDs to avoid iterator invalidation during removal
-        vector<int> flightsToGround(airlineIndex[airlineId].begin(),
-                                    airlineIndex[airlineId].end());
+        vector<int> flightsToGround(group->second.begin(),
+                                    group->second.end());
         for (int flightId : flightsToGround) {
           if (handles[flightId].state == PENDING) {
             pendingFlights.eraseOne(handles[flightId].pendingNode);
@@ -367,194 +670,959 @@ public:
           }
           activeFlights.erase(flightId);
           handles.erase(flightId);
-          airlineIndex[airlineId].erase(flightId);
+          unindexAirline(airlineId, flightId);
         }
       }
     }
-    ss << "Flights of the airlines in the range [" << airlineLow << ", "
-       << airlineHigh << "] have been grounded" << "\n";
-    tick(currentTime);
+    emit(OutputKind::GROUNDED, airlineLow, airlineHigh);
+    return true;
   }
 
   // Add additional runways to the system
   void addRunways(int count, int currentTime) {
     tick(currentTime);
+    if (applyAddRunways(count)) {
+      tick(currentTime);
+    }
+  }
+
+  // Add runways free from the current time, returns true if a tick must
+  // replan
+  bool applyAddRunways(int count) {
     if (count <= 0) {
-      ss << "Invalid input. Please provide a valid number of runways."
-         << "\n";
-      return;
+      emit(OutputKind::INVALID_RUNWAY_COUNT);
+      return false;
     }
     int existingRunways = runwayPool.size();
     for (int i = 0; i < count; i++) {
       runwayPool.push({currentTime, existingRunways + i + 1});
     }
-    ss << "Additional " << count << " Runways are now available" << "\n";
-    tick(currentTime);
+    emit(OutputKind::ADDITIONAL_RUNWAYS, count);
+    return true;
   }
 
   // Update priority of a pending or scheduled flight
   void reprioritize(int flightId, int currentTime, int newPriority) {
     tick(currentTime);
-    if (!handles.count(flightId)) {
-      ss << "Flight " << flightId << " not found" << "\n";
-      return;
-    } else if (handles[flightId].state == IN_PROGRESS ||
-               handles[flightId].state == COMPLETED) {
-      ss << "Cannot reprioritize. Flight " << flightId
-         << " has already departed" << "\n";
-      return;
+    if (applyReprioritize(flightId, newPriority)) {
+      tick(currentTime);
+    }
+  }
+
+  // Change a flight's priority, returns true if a tick must replan
+  bool applyReprioritize(int flightId, int newPriority) {
+    if (!handles.count(flightId) && !retiredFlights->contains(flightId)) {
+      emit(OutputKind::FLIGHT_NOT_FOUND, flightId);
+      return false;
+    } else if (!handles.count(flightId) ||
+               handles[flightId].state == IN_PROGRESS) {
+      emit(OutputKind::CANNOT_REPRIORITIZE, flightId);
+      return false;
     }
 
     if (handles[flightId].state == PENDING) {
       // Update priority in pending flights queue
       auto flightRequest = handles[flightId].pendingNode->value.flightRequest;
+      flightRequest.priority = newPriority;
       handles[flightId].pendingNode = pendingFlights.changeKey(
           handles[flightId].pendingNode,
           PendingFlight(newPriority, handles[flightId].submitTime, flightId,
                         flightRequest));
     } else {
       // Update priority in active flights
-      activeFlights[flightId].flightRequest.priority = newPriority;
+      activeFlights.request(activeFlights.find(flightId)).priority =
+          newPriority;
     }
-    ss << "Priority of Flight " << flightId << " has been updated to "
-       << newPriority << "\n";
-    tick(currentTime);
+    emit(OutputKind::PRIORITY_UPDATED, flightId, newPriority);
+    return true;
   }
 
   // Cancel a pending or scheduled flight
   void cancelFlight(int flightId, int currentTime) {
     tick(currentTime);
-    if (!handles.count(flightId)) {
-      ss << "Flight " << flightId << " does not exist" << "\n";
-      return;
+    if (applyCancel(flightId)) {
+      tick(currentTime);
     }
-    if (handles[flightId].state == IN_PROGRESS ||
-        handles[flightId].state == COMPLETED) {
-      ss << "Cannot cancel: Flight " << flightId << " has already departed"
-         << "\n";
-      return;
+  }
+
+  // Drop a flight that has not started, returns true if a tick must replan
+  bool applyCancel(int flightId) {
+    if (!handles.count(flightId) && !retiredFlights->contains(flightId)) {
+      emit(OutputKind::FLIGHT_DOES_NOT_EXIST, flightId);
+      return false;
+    }
+    if (!handles.count(flightId) || handles[flightId].state == IN_PROGRESS) {
+      emit(OutputKind::CANNOT_CANCEL, flightId);
+      return false;
     }
     // Clean up from all data structures
     if (handles[flightId].state == SCHEDULED) {
       timeTable.eraseOne(handles[flightId].timeTableEntry);
-      airlineIndex[activeFlights[flightId].flightRequest.airlineId].erase(
-          flightId);
+      size_t slot = activeFlights.find(flightId);
+      unindexAirline(activeFlights.request(slot).airlineId, flightId);
     }
     if (handles[flightId].state == PENDING) {
-      airlineIndex[handles[flightId].pendingNode->value.flightRequest.airlineId]
-          .erase(flightId);
+      unindexAirline(
+          handles[flightId].pendingNode->value.flightRequest.airlineId,
+          flightId);
       pendingFlights.eraseOne(handles[flightId].pendingNode);
     }
     activeFlights.erase(flightId);
     handles.erase(flightId);
-    ss << "Flight " << flightId << " has been canceled" << "\n";
-    tick(currentTime);
+    emit(OutputKind::CANCELED, flightId);
+    return true;
+  }
+
+  // Remove a flight from its airline's group, dropping emptied groups
+  void unindexAirline(int airlineId, int flightId) {
+    if (!airlineIndex->count(airlineId)) {
+      return;
+    }
+    auto &groups = airlineIndex.write();
+    auto group = groups.find(airlineId);
+    group->second.erase(flightId);
+    if (group->second.empty()) {
+      groups.erase(group);
+    }
+  }
+
+  // Drop all flights and runways, keeping allocated capacity for reuse
+  void reset() {
+    runwayPool.clear();
+    pendingFlights.clear();
+    activeFlights.clear();
+    timeTable.clear();
+    airlineIndex.write().clear();
+    handles.clear();
+    retiredFlights.write().clear();
+    initialized = false;
+    currentTime = 0;
+  }
+
+  // Capture the current state, shared read-only by what-if forks
+  shared_ptr<const Snapshot> snapshot() const {
+    auto snap = make_shared<Snapshot>();
+    snap->currentTime = currentTime;
+    snap->horizon = horizon;
+    snap->runwayCount = runwayPool.size();
+    snap->activeFlights = activeFlights;
+    snap->airlineIndex = airlineIndex;
+    snap->handles = handles;
+    snap->retiredFlights = retiredFlights;
+    for (auto &entry : snap->handles) {
+      if (entry.second.state == PENDING && entry.second.pendingNode) {
+        snap->pending.push_back(entry.second.pendingNode->value);
+      }
+      entry.second.pendingNode = nullptr;
+    }
+    return snap;
+  }
+
+  // Replace the current state with a snapshot
+  // Runway availability is only rebuilt by the next tick
+  void restore(const Snapshot &snap) {
+    runwayPool.clear();
+    pendingFlights.clear();
+    timeTable.clear();
+    currentTime = snap.currentTime;
+    horizon = snap.horizon;
+    for (int i = 0; i < snap.runwayCount; i++) {
+      runwayPool.push({currentTime, i + 1});
+    }
+    activeFlights = snap.activeFlights;
+    airlineIndex = snap.airlineIndex;
+    handles = snap.handles;
+    retiredFlights = snap.retiredFlights;
+    for (const auto &entry : handles) {
+      if (entry.second.state == SCHEDULED ||
+          entry.second.state == IN_PROGRESS) {
+        timeTable.push(entry.second.timeTableEntry);
+      }
+    }
+    for (const PendingFlight &flight : snap.pending) {
+      handles[flight.flightId].pendingNode = pendingFlights.push(flight);
+    }
+  }
+
+  // Assign every backlog flight its planned slot
+  void materializeBacklog() {
+    unordered_map<int, int> rescheduleETAChanged;
+    schedulePending(INT_MAX, rescheduleETAChanged);
+  }
+
+  // Evaluate candidate changes in parallel against a snapshot of this
+  // scheduler, leaving the live state untouched
+  vector<WhatIfResult> evaluateWhatIf(const vector<WhatIfCandidate> &candidates,
+                                      ThreadPool &pool) const {
+    shared_ptr<const Snapshot> base = snapshot();
+    // Candidates are compared against the full plan, so a backlog is
+    // materialized once here rather than in every fork
+    shared_ptr<const FlightTable<FlightRequest>> planned(base,
+                                                         &base->activeFlights);
+    if (!base->pending.empty()) {
+      GatorAirTrafficSlotScheduler planner;
+      planner.restore(*base);
+      planner.tick(base->currentTime);
+      planner.materializeBacklog();
+      planned = make_shared<const FlightTable<FlightRequest>>(
+          std::move(planner.activeFlights));
+    }
+    vector<future<WhatIfResult>> pending;
+    for (const WhatIfCandidate &candidate : candidates) {
+      pending.push_back(pool.submit([base, planned, candidate] {
+        return evaluateCandidate(*base, *planned, candidate);
+      }));
+    }
+    vector<WhatIfResult> results;
+    for (auto &result : pending) {
+      results.push_back(result.get());
+    }
+    return results;
+  }
+
+  // Apply one candidate to a private copy of the snapshot and diff the ETAs
+  // against before, the snapshot's flights with the backlog materialized
+  static WhatIfResult
+  evaluateCandidate(const Snapshot &base,
+                    const FlightTable<FlightRequest> &before,
+                    const WhatIfCandidate &candidate) {
+    GatorAirTrafficSlotScheduler fork;
+    fork.restore(base);
+    // Landings up to the snapshot's time are already settled; only flights
+    // planned to start right now still need the promotion a leading tick
+    // would give them. The change then applies directly and a single tick
+    // replans and rebuilds the runway pool.
+    fork.promoteStarted();
+    switch (candidate.kind) {
+    case WhatIfCandidate::REPRIORITIZE:
+      fork.applyReprioritize(candidate.arg1, candidate.arg2);
+      break;
+    case WhatIfCandidate::ADD_RUNWAYS:
+      fork.applyAddRunways(candidate.arg1);
+      break;
+    case WhatIfCandidate::GROUND_HOLD:
+      fork.applyGroundHold(candidate.arg1, candidate.arg2);
+      break;
+    case WhatIfCandidate::CANCEL:
+      fork.applyCancel(candidate.arg1);
+      break;
+    }
+    fork.tick(base.currentTime);
+
+    // The candidate runs within the horizon, its backlog is then planned
+    // like the one in before so both sides cover every flight
+    fork.materializeBacklog();
+
+    WhatIfResult result;
+    for (size_t slot = 0; slot < before.size(); slot++) {
+      if (before.state(slot) != SCHEDULED) {
+        continue;
+      }
+      int flightId = before.id(slot);
+      size_t after = fork.activeFlights.find(flightId);
+      if (after == fork.activeFlights.npos) {
+        result.removedFlights.push_back(flightId);
+      } else if (fork.activeFlights.ETA(after) != before.ETA(slot)) {
+        result.etaDeltas.push_back(
+            {flightId, fork.activeFlights.ETA(after) - before.ETA(slot)});
+      }
+    }
+    sort(result.etaDeltas.begin(), result.etaDeltas.end());
+    sort(result.removedFlights.begin(), result.removedFlights.end());
+    return result;
   }
 };
 
-// Quit program and write output to file
-void quit(ifstream &inputFile, char *argv[]) {
-  ss << "Program Terminated!!" << "\n";
-  inputFile.close();
-  string inputFileName =
-      string(argv[1]).substr(0, string(argv[1]).find_last_of('.'));
+using Scheduler = GatorAirTrafficSlotScheduler<SCHEDULER_POLICY>;
+
+// Command-line settings applied to every scheduler the program creates
+struct RunOptions {
+  int horizon = -1;
+  // Sample hardware counters per command and tick phase, dumped to stderr
+  bool perfStats = false;
+  // Parse, schedule and format on three threads
+  bool pipeline = false;
+};
+
+// One input line parsed into a compact record
+struct Command {
+  enum Kind {
+    INITIALIZE,
+    SUBMIT_FLIGHT,
+    CANCEL_FLIGHT,
+    REPRIORITIZE,
+    ADD_RUNWAYS,
+    GROUND_HOLD,
+    TICK,
+    PRINT_ACTIVE,
+    PRINT_SCHEDULE,
+    WHAT_IF,
+    RESET,
+    QUIT,
+    INVALID,
+    END_OF_INPUT // closes a pipelined replay
+  };
+  Kind kind = INVALID;
+  int args[5] = {};
+  string text; // WhatIf candidate list, or why the line is invalid
+};
+
+// Write the text of one output line
+void formatOutput(ostream &out, const OutputEvent &event) {
+  const int *arg = event.args;
+  switch (event.kind) {
+  case OutputKind::INVALID_INPUT:
+    out << "Invalid input" << "\n";
+    break;
+  case OutputKind::RUNWAYS_AVAILABLE:
+    out << arg[0] << " Runways are now available" << "\n";
+    break;
+  case OutputKind::DUPLICATE_FLIGHT:
+    out << "Duplicate FlightID" << "\n";
+    break;
+  case OutputKind::LANDED:
+    out << "Flight " << arg[0] << " has landed at time " << arg[1] << "\n";
+    break;
+  case OutputKind::SCHEDULED:
+    out << "Flight " << arg[0] << " scheduled - ETA: " << arg[1] << "\n";
+    break;
+  case OutputKind::UPDATED_ETAS_BEGIN:
+    out << "Updated ETAs: [";
+    break;
+  case OutputKind::UPDATED_ETA:
+    out << (arg[2] ? ", " : "") << arg[0] << ": " << arg[1];
+    break;
+  case OutputKind::UPDATED_ETAS_END:
+    out << "]" << "\n";
+    break;
+  case OutputKind::NO_FLIGHTS_IN_PERIOD:
+    out << "There are no flights in that time period" << "\n";
+    break;
+  case OutputKind::SCHEDULE_ENTRY:
+    out << "[" << arg[0] << "]" << "\n";
+    break;
+  case OutputKind::ACTIVE_ENTRY:
+    out << "[flight" << arg[0] << ", airline" << arg[1] << ", runway" << arg[2]
+        << ", start" << arg[3] << ", ETA" << arg[4] << "]" << "\n";
+    break;
+  case OutputKind::INVALID_AIRLINE_RANGE:
+    out << "Invalid input. Please provide a valid airline range." << "\n";
+    break;
+  case OutputKind::GROUNDED:
+    out << "Flights of the airlines in the range [" << arg[0] << ", "
+        << arg[1] << "] have been grounded" << "\n";
+    break;
+  case OutputKind::INVALID_RUNWAY_COUNT:
+    out << "Invalid input. Please provide a valid number of runways." << "\n";
+    break;
+  case OutputKind::ADDITIONAL_RUNWAYS:
+    out << "Additional " << arg[0] << " Runways are now available" << "\n";
+    break;
+  case OutputKind::FLIGHT_NOT_FOUND:
+    out << "Flight " << arg[0] << " not found" << "\n";
+    break;
+  case OutputKind::CANNOT_REPRIORITIZE:
+    out << "Cannot reprioritize. Flight " << arg[0] << " has already departed"
+        << "\n";
+    break;
+  case OutputKind::PRIORITY_UPDATED:
+    out << "Priority of Flight " << arg[0] << " has been updated to "
+        << arg[1] << "\n";
+    break;
+  case OutputKind::FLIGHT_DOES_NOT_EXIST:
+    out << "Flight " << arg[0] << " does not exist" << "\n";
+    break;
+  case OutputKind::CANNOT_CANCEL:
+    out << "Cannot cancel: Flight " << arg[0] << " has already departed"
+        << "\n";
+    break;
+  case OutputKind::CANCELED:
+    out << "Flight " << arg[0] << " has been canceled" << "\n";
+    break;
+  case OutputKind::TERMINATED:
+    out << "Program Terminated!!" << "\n";
+    break;
+  case OutputKind::RESET:
+    out << "Scheduler reset" << "\n";
+    break;
+  case OutputKind::TEXT:
+    out << event.text;
+    break;
+  case OutputKind::END_OF_OUTPUT:
+    break;
+  }
+}
+
+// Format and clear the output the scheduler recorded so far
+void drainOutput(Scheduler &scheduler, ostream &out) {
+  for (const OutputEvent &event : scheduler.output) {
+    formatOutput(out, event);
+  }
+  scheduler.output.clear();
+}
+
+// Write a scenario's output next to its input file
+// Returns false if the output file cannot be written
+bool writeOutputFile(const string &inputPath, const string &output,
+                     ostream &log) {
+  string inputFileName = inputPath.substr(0, inputPath.find_last_of('.'));
   ofstream outfile(inputFileName + "_output_file.txt");
   if (!outfile.is_open()) {
-    cerr << "Failed to open output file for writing" << "\n";
-    exit(1);
+    log << "Failed to open output file for writing" << "\n";
+    return false;
   }
-  outfile << ss.str();
-  ss.flush();
-  outfile.flush();
+  outfile << output;
   outfile.close();
-  exit(0);
+  return !outfile.fail();
 }
 
-// Main program entry point
-int main(int argc, char *argv[]) {
-  if (argc != 2)
-    throw std::invalid_argument("Invalid number of arguments");
-  ifstream inputFile(argv[1]);
-  if (!inputFile.is_open()) {
-    cerr << "Failed to open input file" << "\n";
-    return 1;
+// Thread pool shared by what-if evaluations, sized to the machine
+ThreadPool &whatIfPool() {
+  static ThreadPool pool(thread::hardware_concurrency());
+  return pool;
+}
+
+// Parse "Name(a, b); Name(a)" candidate lists of a WhatIf command
+vector<WhatIfCandidate> parseWhatIfCandidates(const string &list) {
+  vector<WhatIfCandidate> candidates;
+  size_t pos = 0;
+  while (pos < list.size()) {
+    size_t start = list.find("(", pos);
+    size_t end = list.find(")", pos);
+    if (start == string::npos || end == string::npos)
+      break;
+    string name = list.substr(pos, start - pos);
+    name.erase(0, name.find_first_not_of(" ;"));
+    string args = list.substr(start + 1, end - start - 1);
+    size_t comma = args.find(",");
+    int arg1 = stoi(args.substr(0, comma));
+    int arg2 = comma == string::npos ? 0 : stoi(args.substr(comma + 1));
+    if (name == "Reprioritize") {
+      candidates.push_back({WhatIfCandidate::REPRIORITIZE, arg1, arg2});
+    } else if (name == "AddRunways") {
+      candidates.push_back({WhatIfCandidate::ADD_RUNWAYS, arg1, arg2});
+    } else if (name == "GroundHold") {
+      candidates.push_back({WhatIfCandidate::GROUND_HOLD, arg1, arg2});
+    } else if (name == "CancelFlight") {
+      candidates.push_back({WhatIfCandidate::CANCEL, arg1, arg2});
+    } else {
+      throw runtime_error("Invalid what-if candidate: " + name);
+    }
+    pos = end + 1;
   }
+  return candidates;
+}
 
-  GatorAirTrafficSlotScheduler scheduler;
+// Print the ETA deltas of each what-if candidate
+void printWhatIf(ostream &out, const string &list,
+                 const vector<WhatIfResult> &results) {
+  size_t pos = 0;
+  for (const WhatIfResult &result : results) {
+    size_t end = list.find(")", pos);
+    string candidate = list.substr(pos, end - pos + 1);
+    candidate.erase(0, candidate.find_first_not_of(" ;"));
+    pos = end + 1;
+    out << "What-if " << candidate << ": ";
+    if (result.etaDeltas.empty() && result.removedFlights.empty()) {
+      out << "no ETA changes" << "\n";
+      continue;
+    }
+    out << "ETA deltas [";
+    for (size_t i = 0; i < result.etaDeltas.size(); i++) {
+      out << (i ? ", " : "") << result.etaDeltas[i].first << ": "
+         << (result.etaDeltas[i].second > 0 ? "+" : "")
+         << result.etaDeltas[i].second;
+    }
+    out << "]";
+    if (!result.removedFlights.empty()) {
+      out << ", removed [";
+      for (size_t i = 0; i < result.removedFlights.size(); i++) {
+        out << (i ? ", " : "") << result.removedFlights[i];
+      }
+      out << "]";
+    }
+    out << "\n";
+  }
+}
 
-  string line;
-  // Process each command from input file
-  while (getline(inputFile, line)) {
+// Name of a command kind, labels its performance counter phase
+const char *commandName(Command::Kind kind) {
+  static const char *const names[] = {
+      "Initialize", "SubmitFlight",  "CancelFlight", "Reprioritize",
+      "AddRunways", "GroundHold",    "Tick",         "PrintActive",
+      "PrintSchedule", "WhatIf",     "Reset",        "Quit",
+      "Invalid",       "EndOfInput"};
+  return names[kind];
+}
+
+// Parse the comma separated integer arguments between the parentheses
+void parseArguments(const string &line, Command &command, int count) {
+  size_t pos = line.find("(");
+  size_t end = line.find(")");
+  for (int i = 0; i < count; i++) {
+    size_t next = i + 1 < count ? line.find(",", pos + 1) : end;
+    command.args[i] = stoi(line.substr(pos + 1, next - pos - 1));
+    pos = next;
+  }
+}
+
+// Parse one command line, a malformed line becomes an INVALID command that
+// fails when executed so errors surface in input order
+Command parseCommand(const string &line) {
+  Command command;
+  try {
     if (line == "Quit()") {
-      quit(inputFile, argv);
-    } else if (line.find("Tick") != string::npos) {
+      command.kind = Command::QUIT;
+    } else if (line == "Reset()") {
+      command.kind = Command::RESET;
+    } else if (line.find("WhatIf") != string::npos) {
       int start = line.find("(");
-      int end = line.find(")");
-      string arg1 = line.substr(start + 1, end - start - 1);
-      scheduler.tick(stoi(arg1));
+      int end = line.rfind(")");
+      command.kind = Command::WHAT_IF;
+      command.text = line.substr(start + 1, end - start - 1);
+    } else if (line.find("Tick") != string::npos) {
+      command.kind = Command::TICK;
+      parseArguments(line, command, 1);
     } else if (line.find("PrintSchedule") != string::npos) {
-      int start = line.find("(");
-      int end1 = line.find(",");
-      int end = line.find(")");
-      string arg1 = line.substr(start + 1, end1 - start - 1);
-      string arg2 = line.substr(end1 + 1, end - end1 - 1);
-      scheduler.printSchedule(stoi(arg1), stoi(arg2));
+      command.kind = Command::PRINT_SCHEDULE;
+      parseArguments(line, command, 2);
     } else if (line.find("PrintActive") != string::npos) {
-      scheduler.printActive();
+      command.kind = Command::PRINT_ACTIVE;
     } else if (line.find("GroundHold") != string::npos) {
-      int start = line.find("(");
-      int end1 = line.find(",");
-      int end2 = line.find(",", end1 + 1);
-      int end = line.find(")");
-      string arg1 = line.substr(start + 1, end1 - start - 1);
-      string arg2 = line.substr(end1 + 1, end2 - end1 - 1);
-      string arg3 = line.substr(end2 + 1, end - end2 - 1);
-      scheduler.groundHold(stoi(arg1), stoi(arg2), stoi(arg3));
+      command.kind = Command::GROUND_HOLD;
+      parseArguments(line, command, 3);
     } else if (line.find("AddRunways") != string::npos) {
-      int start = line.find("(");
-      int end1 = line.find(",");
-      int end = line.find(")");
-      string arg1 = line.substr(start + 1, end1 - start - 1);
-      string arg2 = line.substr(end1 + 1, end - end1 - 1);
-      scheduler.addRunways(stoi(arg1), stoi(arg2));
+      command.kind = Command::ADD_RUNWAYS;
+      parseArguments(line, command, 2);
     } else if (line.find("Reprioritize") != string::npos) {
-      int start = line.find("(");
-      int end1 = line.find(",");
-      int end2 = line.find(",", end1 + 1);
-      int end = line.find(")");
-      string arg1 = line.substr(start + 1, end1 - start - 1);
-      string arg2 = line.substr(end1 + 1, end2 - end1 - 1);
-      string arg3 = line.substr(end2 + 1, end - end2 - 1);
-      scheduler.reprioritize(stoi(arg1), stoi(arg2), stoi(arg3));
+      command.kind = Command::REPRIORITIZE;
+      parseArguments(line, command, 3);
     } else if (line.find("CancelFlight") != string::npos) {
-      int start = line.find("(");
-      int end1 = line.find(",");
-      int end = line.find(")");
-      string arg1 = line.substr(start + 1, end1 - start - 1);
-      string arg2 = line.substr(end1 + 1, end - end1 - 1);
-      scheduler.cancelFlight(stoi(arg1), stoi(arg2));
+      command.kind = Command::CANCEL_FLIGHT;
+      parseArguments(line, command, 2);
     } else if (line.find("Initialize") != string::npos) {
-      int start = line.find("(");
-      int end = line.find(")");
-      string arg1 = line.substr(start + 1, end - start - 1);
-      scheduler.initialize(stoi(arg1));
+      command.kind = Command::INITIALIZE;
+      parseArguments(line, command, 1);
     } else if (line.find("SubmitFlight") != string::npos) {
-      int start = line.find("(");
-      int end1 = line.find(",");
-      int end2 = line.find(",", end1 + 1);
-      int end3 = line.find(",", end2 + 1);
-      int end4 = line.find(",", end3 + 1);
-      int end = line.find(")");
-      string arg1 = line.substr(start + 1, end1 - start - 1);
-      string arg2 = line.substr(end1 + 1, end2 - end1 - 1);
-      string arg3 = line.substr(end2 + 1, end3 - end2 - 1);
-      string arg4 = line.substr(end3 + 1, end4 - end3 - 1);
-      string arg5 = line.substr(end4 + 1, end - end4 - 1);
-      scheduler.submitFlight(stoi(arg1), stoi(arg2), stoi(arg3), stoi(arg4),
-                             stoi(arg5));
+      command.kind = Command::SUBMIT_FLIGHT;
+      parseArguments(line, command, 5);
     } else {
-      throw runtime_error("Invalid command: " + line);
+      command.kind = Command::INVALID;
+      command.text = "Invalid command: " + line;
+    }
+  } catch (const exception &e) {
+    command.kind = Command::INVALID;
+    command.text = e.what();
+  }
+  return command;
+}
+
+// Execute one parsed command, returns false on Quit()
+bool executeCommand(Scheduler &scheduler, const Command &command) {
+  PerfPhase phase(scheduler.perfStats, commandName(command.kind),
+                  scheduler.handles.size());
+  const int *arg = command.args;
+  switch (command.kind) {
+  case Command::INITIALIZE:
+    scheduler.initialize(arg[0]);
+    break;
+  case Command::SUBMIT_FLIGHT:
+    scheduler.submitFlight(arg[0], arg[1], arg[2], arg[3], arg[4]);
+    break;
+  case Command::CANCEL_FLIGHT:
+    scheduler.cancelFlight(arg[0], arg[1]);
+    break;
+  case Command::REPRIORITIZE:
+    scheduler.reprioritize(arg[0], arg[1], arg[2]);
+    break;
+  case Command::ADD_RUNWAYS:
+    scheduler.addRunways(arg[0], arg[1]);
+    break;
+  case Command::GROUND_HOLD:
+    scheduler.groundHold(arg[0], arg[1], arg[2]);
+    break;
+  case Command::TICK:
+    scheduler.tick(arg[0]);
+    break;
+  case Command::PRINT_ACTIVE:
+    scheduler.printActive();
+    break;
+  case Command::PRINT_SCHEDULE:
+    scheduler.printSchedule(arg[0], arg[1]);
+    break;
+  case Command::WHAT_IF: {
+    ostringstream text;
+    printWhatIf(text, command.text,
+                scheduler.evaluateWhatIf(parseWhatIfCandidates(command.text),
+                                         whatIfPool()));
+    scheduler.emitText(text.str());
+    break;
+  }
+  case Command::RESET:
+    scheduler.reset();
+    scheduler.emit(OutputKind::RESET);
+    break;
+  case Command::QUIT:
+    scheduler.emit(OutputKind::TERMINATED);
+    return false;
+  case Command::INVALID:
+  case Command::END_OF_INPUT:
+    throw runtime_error(command.text);
+  }
+  return true;
+}
+
+// Set by SIGINT/SIGTERM to stop the server loop
+volatile sig_atomic_t serverStopping = 0;
+
+// Connected server client with its unparsed input and unsent replies
+struct ServerClient {
+  int fd;
+  string input;
+  string output;
+  bool closing;
+};
+
+// Send as much pending output as the socket accepts without blocking
+bool flushClient(ServerClient &client) {
+  while (!client.output.empty()) {
+    ssize_t sent =
+        send(client.fd, client.output.data(), client.output.size(), 0);
+    if (sent < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    client.output.erase(0, sent);
+  }
+  return true;
+}
+
+// Execute every complete line received so far, queueing one reply per
+// command: its output lines followed by an empty line
+// output is scratch space for formatting one reply
+void serveCommands(Scheduler &scheduler, stringstream &output,
+                   ServerClient &client) {
+  size_t pos = 0, newline;
+  while (!client.closing &&
+         (newline = client.input.find('\n', pos)) != string::npos) {
+    string line = client.input.substr(pos, newline - pos);
+    pos = newline + 1;
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (line.empty())
+      continue;
+    Command command = parseCommand(line);
+    // Clients share the scheduler, a second Initialize() would add its
+    // runways on top of the existing ones, and a command failing halfway
+    // on a scheduler without runways would leave it inconsistent
+    if (command.kind == Command::INITIALIZE && scheduler.initialized) {
+      command = {Command::INVALID,
+                 {},
+                 "Scheduler already initialized, send Reset() first"};
+    } else if (!scheduler.initialized && command.kind != Command::INITIALIZE &&
+               command.kind != Command::RESET &&
+               command.kind != Command::WHAT_IF &&
+               command.kind != Command::QUIT &&
+               command.kind != Command::INVALID) {
+      command = {Command::INVALID,
+                 {},
+                 "Scheduler not initialized, send Initialize(n) first"};
+    }
+    try {
+      // Quit() only ends this client's connection
+      client.closing = !executeCommand(scheduler, command);
+    } catch (const exception &e) {
+      scheduler.emitText(string(e.what()) + "\n");
+    }
+    drainOutput(scheduler, output);
+    client.output += output.str();
+    client.output += "\n";
+    output.str("");
+    output.clear();
+  }
+  client.input.erase(0, pos);
+}
+
+// Serve commands over a Unix domain socket with one warm scheduler
+int runServer(const char *socketPath, const RunOptions &options) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (strlen(socketPath) >= sizeof(address.sun_path)) {
+    cerr << "Socket path too long" << "\n";
+    return 1;
+  }
+  strcpy(address.sun_path, socketPath);
+
+  // Only a stale socket from an earlier server may be replaced
+  struct stat existing;
+  if (lstat(socketPath, &existing) == 0) {
+    if (!S_ISSOCK(existing.st_mode)) {
+      cerr << "Failed to listen on " << socketPath << ": "
+           << strerror(EADDRINUSE) << "\n";
+      return 1;
+    }
+    unlink(socketPath);
+  }
+
+  int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0 ||
+      bind(listenFd, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) < 0 ||
+      listen(listenFd, SOMAXCONN) < 0) {
+    cerr << "Failed to listen on " << socketPath << ": " << strerror(errno)
+         << "\n";
+    return 1;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, [](int) { serverStopping = 1; });
+  signal(SIGTERM, [](int) { serverStopping = 1; });
+
+  stringstream output;
+  Scheduler scheduler;
+  scheduler.horizon = options.horizon;
+  PerfStats perfStats;
+  if (options.perfStats && perfStats.open(cerr))
+    scheduler.perfStats = &perfStats;
+  vector<ServerClient> clients;
+  vector<pollfd> fds;
+  char buffer[1 << 16];
+
+  while (!serverStopping) {
+    fds.assign(1, {listenFd, POLLIN, 0});
+    for (const ServerClient &client : clients) {
+      short events = client.closing ? 0 : POLLIN;
+      if (!client.output.empty())
+        events |= POLLOUT;
+      fds.push_back({client.fd, events, 0});
+    }
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      cerr << "poll failed: " << strerror(errno) << "\n";
+      break;
+    }
+
+    if (fds[0].revents & POLLIN) {
+      int clientFd = accept(listenFd, nullptr, nullptr);
+      if (clientFd >= 0) {
+        fcntl(clientFd, F_SETFL, fcntl(clientFd, F_GETFL) | O_NONBLOCK);
+        clients.push_back({clientFd, "", "", false});
+      }
+    }
+
+    // Clients accepted this round have no pollfd entry yet
+    size_t polled = fds.size() - 1;
+    for (size_t i = 0; i < polled; i++) {
+      ServerClient &client = clients[i];
+      bool alive = true;
+      if (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) {
+        ssize_t received = recv(client.fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+          client.input.append(buffer, received);
+          serveCommands(scheduler, output, client);
+        } else if (received == 0 ||
+                   (errno != EAGAIN && errno != EWOULDBLOCK &&
+                    errno != EINTR)) {
+          alive = false;
+        }
+      }
+      alive = flushClient(client) && alive;
+      if (!alive || (client.closing && client.output.empty())) {
+        close(client.fd);
+        client.fd = -1;
+      }
     }
+    erase_if(clients, [](const ServerClient &c) { return c.fd < 0; });
   }
+
+  for (const ServerClient &client : clients)
+    close(client.fd);
+  close(listenFd);
+  unlink(socketPath);
+  if (scheduler.perfStats)
+    perfStats.dump(cerr);
   return 0;
 }
+
+// Run the commands of input one after another on the calling thread
+// Returns true once Quit() has run
+bool replay(istream &input, Scheduler &scheduler, ostream &output) {
+  string line;
+  // Process each command from input file
+  while (getline(input, line)) {
+    bool running = executeCommand(scheduler, parseCommand(line));
+    drainOutput(scheduler, output);
+    if (!running) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Same as replay, with parsing on one thread, scheduling on the calling
+// thread and formatting on a third, connected by SPSC rings
+// Commands still run one at a time in input order, so output is identical
+bool replayPipelined(istream &input, Scheduler &scheduler, ostream &output) {
+  SpscRing<Command> commands(1024);
+  SpscRing<OutputEvent> events(4096);
+  atomic<bool> stopping{false};
+
+  thread parser([&] {
+    string line;
+    while (!stopping.load(memory_order_relaxed) && getline(input, line)) {
+      commands.push(parseCommand(line));
+    }
+    commands.push({Command::END_OF_INPUT, {}, {}});
+  });
+  thread emitter([&] {
+    for (OutputEvent event = events.pop();
+         event.kind != OutputKind::END_OF_OUTPUT; event = events.pop()) {
+      formatOutput(output, event);
+    }
+  });
+
+  bool quit = false;
+  bool inputDone = false;
+  exception_ptr error;
+  try {
+    while (!quit) {
+      Command command = commands.pop();
+      if (command.kind == Command::END_OF_INPUT) {
+        inputDone = true;
+        break;
+      }
+      quit = !executeCommand(scheduler, command);
+      for (OutputEvent &event : scheduler.output) {
+        events.push(std::move(event));
+      }
+      scheduler.output.clear();
+    }
+  } catch (...) {
+    error = current_exception();
+  }
+
+  // Stop the parser, it may be blocked on a full ring until drained
+  stopping = true;
+  while (!inputDone) {
+    inputDone = commands.pop().kind == Command::END_OF_INPUT;
+  }
+  events.push({OutputKind::END_OF_OUTPUT, {}, {}});
+  parser.join();
+  emitter.join();
+  if (error) {
+    rethrow_exception(error);
+  }
+  return quit;
+}
+
+// Replay one input file in its own scheduler and write its output file on
+// Quit(), returns false if a file cannot be opened or written
+bool runFile(const string &inputPath, const RunOptions &options,
+             ostream &log) {
+  ifstream inputFile(inputPath);
+  if (!inputFile.is_open()) {
+    log << "Failed to open input file" << "\n";
+    return false;
+  }
+
+  stringstream output;
+  Scheduler scheduler;
+  scheduler.horizon = options.horizon;
+  PerfStats perfStats;
+  if (options.perfStats && perfStats.open(log))
+    scheduler.perfStats = &perfStats;
+
+  bool quit = options.pipeline ? replayPipelined(inputFile, scheduler, output)
+                               : replay(inputFile, scheduler, output);
+  if (!quit) {
+    return true;
+  }
+  if (scheduler.perfStats)
+    perfStats.dump(log);
+  return writeOutputFile(inputPath, output.str(), log);
+}
+
+// Expand batch arguments into input files, a directory contributes its
+// regular files in name order, skipping outputs of earlier runs
+vector<string> batchInputs(char *paths[], int count) {
+  vector<string> inputs;
+  for (int i = 0; i < count; i++) {
+    filesystem::path path(paths[i]);
+    if (!filesystem::is_directory(path)) {
+      inputs.push_back(path.string());
+      continue;
+    }
+    vector<string> files;
+    for (const auto &entry : filesystem::directory_iterator(path)) {
+      if (entry.is_regular_file() &&
+          !entry.path().filename().string().ends_with("_output_file.txt")) {
+        files.push_back(entry.path().string());
+      }
+    }
+    sort(files.begin(), files.end());
+    inputs.insert(inputs.end(), files.begin(), files.end());
+  }
+  return inputs;
+}
+
+// Run every input file in its own scheduler on a pool sized to the cores
+// Diagnostics are printed per file in input order
+int runBatch(const vector<string> &inputs, const RunOptions &options) {
+  ThreadPool pool(thread::hardware_concurrency());
+  vector<future<pair<bool, string>>> results;
+  for (const string &input : inputs) {
+    results.push_back(pool.submit([&options, input] {
+      ostringstream log;
+      bool ok;
+      try {
+        ok = runFile(input, options, log);
+      } catch (const exception &e) {
+        log << e.what() << "\n";
+        ok = false;
+      }
+      return make_pair(ok, log.str());
+    }));
+  }
+
+  size_t failed = 0;
+  for (size_t i = 0; i < inputs.size(); i++) {
+    auto [ok, log] = results[i].get();
+    if (!log.empty()) {
+      cerr << inputs[i] << ":" << "\n" << log;
+    }
+    failed += !ok;
+  }
+  if (failed) {
+    cerr << failed << " of " << inputs.size() << " scenarios failed" << "\n";
+    return 1;
+  }
+  return 0;
+}
+
+// Main program entry point
+// Usage: [--horizon minutes] [--perf-stats] [--pipeline]
+//        (input_file | --batch path... | --serve socket_path)
+int main(int argc, char *argv[]) {
+  RunOptions options;
+  int arg = 1;
+  while (arg < argc) {
+    if (arg + 1 < argc && string(argv[arg]) == "--horizon") {
+      options.horizon = stoi(argv[arg + 1]);
+      arg += 2;
+    } else if (string(argv[arg]) == "--perf-stats") {
+      options.perfStats = true;
+      arg++;
+    } else if (string(argv[arg]) == "--pipeline") {
+      options.pipeline = true;
+      arg++;
+    } else {
+      break;
+    }
+  }
+  if (argc - arg == 2 && string(argv[arg]) == "--serve")
+    return runServer(argv[arg + 1], options);
+  if (argc - arg >= 2 && string(argv[arg]) == "--batch")
+    return runBatch(batchInputs(argv + arg + 1, argc - arg - 1), options);
+  if (argc - arg != 1)
+    throw std::invalid_argument("Invalid number of arguments");
+  return runFile(argv[arg], options, cerr) ? 0 : 1;
+}
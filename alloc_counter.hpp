@@ -0,0 +1,41 @@
+#pragma once
+// Counts global heap allocations when built with -DGATOR_COUNT_ALLOCATIONS
+// and reports the total on stderr at exit (read by make perf-check)
+#ifdef GATOR_COUNT_ALLOCATIONS
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<unsigned long long> allocationCount{0};
+
+// GCC pairs inlined delete calls with the library new and warns falsely
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(std::size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void *memory = std::malloc(size ? size : 1))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// Prints the count when static objects are destroyed, also after exit()
+struct AllocationReport {
+  ~AllocationReport() {
+    std::fprintf(stderr, "allocations: %llu\n", allocationCount.load());
+  }
+};
+
+inline AllocationReport allocationReport;
+#endif
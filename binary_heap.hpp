@@ -85,7 +85,9 @@ public:
       return false;
     swap(&data_[arrIndex], &data_[size() - 1]);
     data_.pop_back();
-    bubbleDown(arrIndex);
+    // The moved-in last element may belong above or below the hole
+    if (arrIndex < size() && bubbleUp(arrIndex) == arrIndex)
+      bubbleDown(arrIndex);
     return true;
   }
 
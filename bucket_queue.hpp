@@ -0,0 +1,239 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "pairing_heap.hpp"
+
+// Node structure for bucket queue, doubles as the stable handle
+template <typename T> struct BucketQueueNode {
+  T value;
+  int level{-1};        // bucket index, -1 while in the overflow heap
+  std::size_t index{0}; // position inside the bucket array
+  PairingHeapNode<BucketQueueNode<T> *> *overflow{nullptr};
+};
+
+// Bucket queue for priorities in [MinPriority, MaxPriority]
+// One array per priority level, the highest non-empty level is found through
+// a bitmap. Within a level elements are ordered by Compare, which must order
+// by priority first (higher priority = better) like CompPendingFlight.
+// Elements whose priority falls outside the range go to a pairing heap.
+template <typename T, typename Compare, typename PriorityOf, int MinPriority,
+          int MaxPriority>
+class BucketQueue {
+  static_assert(MaxPriority >= MinPriority, "Empty priority range");
+  static_assert(MaxPriority - MinPriority < 64,
+                "Bucket bitmap supports at most 64 priority levels");
+
+  using Node = BucketQueueNode<T>;
+
+  // Orders overflow heap entries by the values they point to
+  struct CompNode {
+    Compare comp_{};
+    bool operator()(const Node *a, const Node *b) const {
+      return comp_(a->value, b->value);
+    }
+  };
+
+  // Elements of one priority level, best first from head onwards
+  // Erased elements leave a nullptr behind until the level is compacted
+  struct Bucket {
+    std::vector<Node *> items;
+    std::size_t head{0};
+    std::size_t live{0};
+    bool sorted{true};
+  };
+
+  static constexpr int kLevels = MaxPriority - MinPriority + 1;
+
+  Compare comp_{};
+  PriorityOf priorityOf_{};
+  Bucket buckets_[kLevels];
+  std::uint64_t nonEmpty_{0};
+  std::size_t totalNodes{0};
+  PairingHeap<Node *, CompNode> overflow_;
+
+  static bool inRange(int priority) {
+    return priority >= MinPriority && priority <= MaxPriority;
+  }
+
+  // Appends a node to its level, keeping the sorted flag up to date
+  void place(Node *theNode, int level) {
+    Bucket &bucket = buckets_[level];
+    if (bucket.live == 0) {
+      bucket.items.clear();
+      bucket.head = 0;
+      bucket.sorted = true;
+    } else if (bucket.items.size() >= 2 * bucket.live + 64) {
+      compact(bucket);
+    }
+    if (bucket.live > 0 && bucket.sorted) {
+      Node *tail = bucket.items.back();
+      if (!tail || !comp_(tail->value, theNode->value))
+        bucket.sorted = false;
+    }
+    theNode->level = level;
+    theNode->index = bucket.items.size();
+    bucket.items.push_back(theNode);
+    bucket.live++;
+    nonEmpty_ |= std::uint64_t{1} << level;
+  }
+
+  // Drops erased slots and restores order after out-of-order pushes
+  void compact(Bucket &bucket) {
+    auto first = bucket.items.begin() + bucket.head;
+    auto last = std::remove(first, bucket.items.end(), nullptr);
+    bucket.items.erase(last, bucket.items.end());
+    bucket.items.erase(bucket.items.begin(), first);
+    bucket.head = 0;
+    if (!bucket.sorted) {
+      std::sort(bucket.items.begin(), bucket.items.end(),
+                [this](const Node *a, const Node *b) {
+                  return comp_(a->value, b->value);
+                });
+      bucket.sorted = true;
+    }
+    for (std::size_t i = 0; i < bucket.items.size(); i++)
+      bucket.items[i]->index = i;
+  }
+
+  // Returns the best node of the highest non-empty level
+  Node *bucketTop() {
+    if (!nonEmpty_)
+      return nullptr;
+    Bucket &bucket = buckets_[std::bit_width(nonEmpty_) - 1];
+    if (!bucket.sorted)
+      compact(bucket);
+    while (!bucket.items[bucket.head])
+      bucket.head++;
+    return bucket.items[bucket.head];
+  }
+
+  // Removes a node from its level without freeing it
+  void unlink(Node *theNode) {
+    Bucket &bucket = buckets_[theNode->level];
+    bucket.items[theNode->index] = nullptr;
+    if (--bucket.live == 0) {
+      nonEmpty_ &= ~(std::uint64_t{1} << theNode->level);
+    } else if (theNode->index == bucket.head) {
+      bucket.head++;
+    }
+  }
+
+  // Files a node under its priority level or the overflow heap
+  void insert(Node *theNode) {
+    int priority = priorityOf_(theNode->value);
+    if (inRange(priority)) {
+      place(theNode, priority - MinPriority);
+    } else {
+      theNode->level = -1;
+      theNode->overflow = overflow_.push(theNode);
+    }
+  }
+
+  // Returns the better of the bucket top and the overflow top
+  Node *bestNode() {
+    Node *best = bucketTop();
+    if (!overflow_.empty() &&
+        (!best || comp_(overflow_.top()->value, best->value)))
+      return overflow_.top();
+    return best;
+  }
+
+  // Removes a node from wherever it is stored without freeing it
+  void detach(Node *theNode) {
+    if (theNode->level >= 0) {
+      unlink(theNode);
+    } else {
+      overflow_.eraseOne(theNode->overflow);
+      theNode->overflow = nullptr;
+    }
+  }
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using handle_type = Node *;
+
+  // An out-of-order push costs a sort of its level on the next pop
+  static constexpr bool kPrefersOrderedPushes = true;
+
+  BucketQueue() = default;
+
+  // Inserts a new element and returns its handle
+  Node *push(const T &value) {
+    Node *newNode = new Node{value};
+    insert(newNode);
+    totalNodes++;
+    return newNode;
+  }
+
+  // Returns the top element without removing it
+  const T &top() {
+    Node *best = bestNode();
+    if (!best)
+      throw std::runtime_error("BucketQueue is empty (no top)");
+    return best->value;
+  }
+
+  // Removes and returns the top element
+  T pop() {
+    Node *best = bestNode();
+    if (!best)
+      throw std::runtime_error("BucketQueue is empty");
+    T value = best->value;
+    eraseOne(best);
+    return value;
+  }
+
+  // Changes the key of a node and repositions it, the handle stays valid
+  Node *changeKey(Node *theNode, T newValue) {
+    if (!theNode)
+      throw std::runtime_error("Node to change doesn't exist");
+    detach(theNode);
+    theNode->value = newValue;
+    insert(theNode);
+    return theNode;
+  }
+
+  // Removes a specific node from the queue
+  bool eraseOne(Node *theNode) {
+    if (!theNode)
+      return false;
+    detach(theNode);
+    totalNodes--;
+    delete theNode;
+    return true;
+  }
+
+  bool empty() const noexcept { return totalNodes == 0; }
+
+  size_type size() const noexcept { return totalNodes; }
+
+  ~BucketQueue() { clear(); }
+
+  // Removes all elements from the queue
+  void clear() noexcept {
+    for (Bucket &bucket : buckets_) {
+      for (std::size_t i = bucket.head; i < bucket.items.size(); i++)
+        delete bucket.items[i];
+      bucket.items.clear();
+      bucket.head = 0;
+      bucket.live = 0;
+      bucket.sorted = true;
+    }
+    while (!overflow_.empty())
+      delete overflow_.pop();
+    nonEmpty_ = 0;
+    totalNodes = 0;
+  }
+
+  BucketQueue(const BucketQueue &) = delete;
+  BucketQueue &operator=(const BucketQueue &) = delete;
+  BucketQueue(BucketQueue &&) = delete;
+  BucketQueue &operator=(BucketQueue &&) = delete;
+};
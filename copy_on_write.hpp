@@ -0,0 +1,45 @@
+#pragma once
+#include <memory>
+
+// Value shared by copies until one of them writes to it
+// Copying only shares the pointer; write() gives the writer a private copy
+// first if the value was ever shared. Copies may be read concurrently from
+// several threads, each writer must own its CopyOnWrite.
+template <typename T> class CopyOnWrite {
+private:
+  std::shared_ptr<T> value_ = std::make_shared<T>();
+  // Set on both sides of a copy, cleared once this side has its own value
+  mutable bool shared_ = false;
+
+public:
+  CopyOnWrite() = default;
+
+  CopyOnWrite(const CopyOnWrite &other)
+      : value_(other.value_), shared_(true) {
+    // Copies of an already shared value only read the source
+    if (!other.shared_)
+      other.shared_ = true;
+  }
+
+  CopyOnWrite &operator=(const CopyOnWrite &other) {
+    if (this != &other) {
+      value_ = other.value_;
+      shared_ = true;
+      if (!other.shared_)
+        other.shared_ = true;
+    }
+    return *this;
+  }
+
+  const T &operator*() const { return *value_; }
+  const T *operator->() const { return value_.get(); }
+
+  // Writable value, copied first if other copies may still read it
+  T &write() {
+    if (shared_) {
+      value_ = std::make_shared<T>(*value_);
+      shared_ = false;
+    }
+    return *value_;
+  }
+};
@@ -0,0 +1,218 @@
+#pragma once
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// -DFLIGHT_TABLE_SCALAR keeps x86-64 builds on the scalar kernel
+#if defined(__x86_64__) && !defined(FLIGHT_TABLE_SCALAR)
+#include <immintrin.h>
+#define FLIGHT_TABLE_AVX2 1
+#endif
+
+// Conditions a flight must meet to be selected, ranges are inclusive
+struct FlightFilter {
+  int state;
+  int startMin{INT_MIN};
+  int startMax{INT_MAX};
+  int etaMin{INT_MIN};
+  int etaMax{INT_MAX};
+};
+
+// Active flights as a structure of arrays: one dense column per field plus
+// an ID -> slot index. Scans over startTime/ETA/state touch only the columns
+// they filter on and run as SIMD compare-and-compress kernels.
+// Erasing moves the last row into the freed slot, so slots are not stable
+// across erase.
+template <typename Request> class FlightTable {
+private:
+  std::vector<int> ids_;
+  std::vector<int> runwayIds_;
+  std::vector<int> startTimes_;
+  std::vector<int> ETAs_;
+  std::vector<int> states_;
+  std::vector<Request> requests_;
+  std::unordered_map<int, std::uint32_t> slots_;
+
+  static bool matches(const FlightFilter &filter, int state, int startTime,
+                      int ETA) {
+    return state == filter.state && startTime >= filter.startMin &&
+           startTime <= filter.startMax && ETA >= filter.etaMin &&
+           ETA <= filter.etaMax;
+  }
+
+  // Scalar filter over slots [first, size)
+  std::size_t selectScalar(const FlightFilter &filter, std::size_t first,
+                           std::uint32_t *out) const {
+    std::size_t count = 0;
+    for (std::size_t i = first; i < ids_.size(); i++) {
+      // Branch-free append: always write, advance only on a match
+      out[count] = static_cast<std::uint32_t>(i);
+      count += matches(filter, states_[i], startTimes_[i], ETAs_[i]);
+    }
+    return count;
+  }
+
+#ifdef FLIGHT_TABLE_AVX2
+  // Lane permutation moving the set lanes of an 8-bit mask to the front
+  struct CompressTable {
+    alignas(32) std::uint32_t lanes[256][8];
+    constexpr CompressTable() : lanes{} {
+      for (int mask = 0; mask < 256; mask++) {
+        int next = 0;
+        for (int lane = 0; lane < 8; lane++) {
+          if (mask & (1 << lane))
+            lanes[mask][next++] = lane;
+        }
+      }
+    }
+  };
+
+  // Eight rows per step: compare, movemask, then compress the matching
+  // slot indices to the output with one permute and an unaligned store
+  __attribute__((target("avx2"))) std::size_t
+  selectAVX2(const FlightFilter &filter, std::uint32_t *out) const {
+    static constexpr CompressTable compress;
+    const __m256i state = _mm256_set1_epi32(filter.state);
+    const __m256i startMin = _mm256_set1_epi32(filter.startMin);
+    const __m256i startMax = _mm256_set1_epi32(filter.startMax);
+    const __m256i etaMin = _mm256_set1_epi32(filter.etaMin);
+    const __m256i etaMax = _mm256_set1_epi32(filter.etaMax);
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + 8 <= ids_.size(); i += 8) {
+      __m256i start = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(startTimes_.data() + i));
+      __m256i eta = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(ETAs_.data() + i));
+      __m256i states = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(states_.data() + i));
+      __m256i reject = _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpgt_epi32(startMin, start),
+                          _mm256_cmpgt_epi32(start, startMax)),
+          _mm256_or_si256(_mm256_cmpgt_epi32(etaMin, eta),
+                          _mm256_cmpgt_epi32(eta, etaMax)));
+      __m256i accept =
+          _mm256_andnot_si256(reject, _mm256_cmpeq_epi32(states, state));
+      int mask = _mm256_movemask_ps(_mm256_castsi256_ps(accept));
+      __m256i lanes = _mm256_load_si256(
+          reinterpret_cast<const __m256i *>(compress.lanes[mask]));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + count),
+                          _mm256_permutevar8x32_epi32(index, lanes));
+      count += __builtin_popcount(mask);
+      index = _mm256_add_epi32(index, step);
+    }
+    return count + selectScalar(filter, i, out + count);
+  }
+
+  static bool hasAVX2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+  }
+#endif
+
+public:
+  using size_type = std::size_t;
+  static constexpr size_type npos = static_cast<size_type>(-1);
+
+  // Slot of a flight, npos if absent
+  size_type find(int flightId) const {
+    auto slot = slots_.find(flightId);
+    return slot == slots_.end() ? npos : slot->second;
+  }
+
+  bool contains(int flightId) const { return slots_.count(flightId) != 0; }
+
+  // Inserts a flight or overwrites its row, returns its slot
+  size_type assign(int flightId, int runwayId, int startTime, int ETA,
+                   int state, const Request &request) {
+    auto [slot, inserted] = slots_.try_emplace(
+        flightId, static_cast<std::uint32_t>(ids_.size()));
+    if (inserted) {
+      ids_.push_back(flightId);
+      runwayIds_.push_back(runwayId);
+      startTimes_.push_back(startTime);
+      ETAs_.push_back(ETA);
+      states_.push_back(state);
+      requests_.push_back(request);
+      return slot->second;
+    }
+    size_type i = slot->second;
+    runwayIds_[i] = runwayId;
+    startTimes_[i] = startTime;
+    ETAs_[i] = ETA;
+    states_[i] = state;
+    requests_[i] = request;
+    return i;
+  }
+
+  // Removes a flight by moving the last row into its slot
+  bool erase(int flightId) {
+    auto slot = slots_.find(flightId);
+    if (slot == slots_.end())
+      return false;
+    size_type i = slot->second;
+    size_type last = ids_.size() - 1;
+    slots_.erase(slot);
+    if (i != last) {
+      ids_[i] = ids_[last];
+      runwayIds_[i] = runwayIds_[last];
+      startTimes_[i] = startTimes_[last];
+      ETAs_[i] = ETAs_[last];
+      states_[i] = states_[last];
+      requests_[i] = std::move(requests_[last]);
+      slots_[ids_[i]] = static_cast<std::uint32_t>(i);
+    }
+    ids_.pop_back();
+    runwayIds_.pop_back();
+    startTimes_.pop_back();
+    ETAs_.pop_back();
+    states_.pop_back();
+    requests_.pop_back();
+    return true;
+  }
+
+  // Slots of all flights matching the filter, in slot order
+  void select(const FlightFilter &filter,
+              std::vector<std::uint32_t> &slots) const {
+    // Kernels store whole vectors past the last match
+    slots.resize(ids_.size() + 8);
+#ifdef FLIGHT_TABLE_AVX2
+    if (hasAVX2()) {
+      slots.resize(selectAVX2(filter, slots.data()));
+      return;
+    }
+#endif
+    slots.resize(selectScalar(filter, 0, slots.data()));
+  }
+
+  int id(size_type slot) const { return ids_[slot]; }
+  int &runwayId(size_type slot) { return runwayIds_[slot]; }
+  int runwayId(size_type slot) const { return runwayIds_[slot]; }
+  int &startTime(size_type slot) { return startTimes_[slot]; }
+  int startTime(size_type slot) const { return startTimes_[slot]; }
+  int &ETA(size_type slot) { return ETAs_[slot]; }
+  int ETA(size_type slot) const { return ETAs_[slot]; }
+  int &state(size_type slot) { return states_[slot]; }
+  int state(size_type slot) const { return states_[slot]; }
+  Request &request(size_type slot) { return requests_[slot]; }
+  const Request &request(size_type slot) const { return requests_[slot]; }
+
+  size_type size() const noexcept { return ids_.size(); }
+
+  bool empty() const noexcept { return ids_.empty(); }
+
+  void clear() noexcept {
+    ids_.clear();
+    runwayIds_.clear();
+    startTimes_.clear();
+    ETAs_.clear();
+    states_.clear();
+    requests_.clear();
+    slots_.clear();
+  }
+};
@@ -1,6 +1,9 @@
 #pragma once
+#include <concepts>
 #include <functional>
 #include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 // Node structure for pairing heap
@@ -11,12 +14,79 @@ template <typename T> struct PairingHeapNode {
   PairingHeapNode<T> *rightSibling{nullptr};
 };
 
+// Default key extractor of PairingHeap, keeps no index
+struct NoPairingHeapKey {};
+
+// Key -> node index kept by a PairingHeap with a key extractor
+template <typename T, typename KeyOf> struct PairingHeapIndex {
+  using key_type =
+      std::decay_t<std::invoke_result_t<const KeyOf &, const T &>>;
+  using type = std::unordered_map<key_type, PairingHeapNode<T> *>;
+};
+
+template <typename T> struct PairingHeapIndex<T, NoPairingHeapKey> {
+  struct type {};
+};
+
 // Pairing heap implementation with customizable comparison
-template <typename T, typename Compare = std::greater<T>> class PairingHeap {
+// With a KeyOf extractor every element needs a unique key, and a key -> node
+// index makes find(key), eraseOne(value) and changeKey(value, newValue) O(1)
+// lookups instead of a full tree walk
+template <typename T, typename Compare = std::greater<T>,
+          typename KeyOf = NoPairingHeapKey>
+class PairingHeap {
 public:
+  static constexpr bool kIndexed = !std::is_same_v<KeyOf, NoPairingHeapKey>;
+
   Compare comp_{};
   std::size_t totalNodes{0};
   PairingHeapNode<T> *root_{nullptr};
+  [[no_unique_address]] KeyOf keyOf_{};
+  [[no_unique_address]] typename PairingHeapIndex<T, KeyOf>::type index_{};
+
+  // Moves a node to the index slot of newValue's key
+  void reindex(PairingHeapNode<T> *theNode, const T &newValue) {
+    if constexpr (kIndexed) {
+      auto oldKey = keyOf_(theNode->value);
+      auto newKey = keyOf_(newValue);
+      if (oldKey == newKey)
+        return;
+      if (!index_.emplace(newKey, theNode).second)
+        throw std::invalid_argument("PairingHeap key already present");
+      index_.erase(oldKey);
+    }
+  }
+
+  // Two pass merging of a sibling list into one tree
+  PairingHeapNode<T> *mergePairs(PairingHeapNode<T> *childPointer) {
+    std::vector<PairingHeapNode<T> *> meldStack;
+    while (childPointer && childPointer->rightSibling) {
+      PairingHeapNode<T> *first = childPointer;
+      PairingHeapNode<T> *second = childPointer->rightSibling;
+      childPointer = second->rightSibling;
+      meldStack.push_back(meld(first, second));
+    }
+
+    if (childPointer) {
+      if (!meldStack.empty()) {
+        PairingHeapNode<T> *temp = meldStack.back();
+        meldStack.pop_back();
+        meldStack.push_back(meld(temp, childPointer));
+      } else
+        meldStack.push_back(childPointer);
+    }
+
+    PairingHeapNode<T> *second = nullptr;
+    while (!meldStack.empty()) {
+      PairingHeapNode<T> *first = meldStack.back();
+      meldStack.pop_back();
+      second = meld(first, second);
+    }
+    if (second) {
+      second->rightSibling = second->leftSibling = nullptr;
+    }
+    return second;
+  }
 
   // Removes a node from its current position in the heap
   void detachNode(PairingHeapNode<T> *theNode) {
@@ -73,6 +143,7 @@ public:
 
   using value_type = T;
   using size_type = std::size_t;
+  using handle_type = PairingHeapNode<T> *;
 
   PairingHeap() = default;
 
@@ -87,28 +158,46 @@ public:
 
   // Inserts a new element and returns the node pointer
   PairingHeapNode<T> *push(const T &value) {
+    PairingHeapNode<T> **slot = nullptr;
+    if constexpr (kIndexed) {
+      auto [entry, inserted] = index_.try_emplace(keyOf_(value), nullptr);
+      if (!inserted)
+        throw std::invalid_argument("PairingHeap key already present");
+      slot = &entry->second;
+    }
     PairingHeapNode<T> *newNode =
         new PairingHeapNode<T>{value, nullptr, nullptr, nullptr};
+    if (slot)
+      *slot = newNode;
     root_ = meld(root_, newNode);
     totalNodes++;
     return newNode;
   }
 
-  // Changes the key of a node and repositions it
+  // Changes the key of a node and repositions it, the node stays valid
   PairingHeapNode<T> *changeKey(PairingHeapNode<T> *theNode, T newValue) {
     if (!theNode)
       throw std::runtime_error("Node to change doesn't exist");
 
+    reindex(theNode, newValue);
     T value = theNode->value;
+    theNode->value = newValue;
 
-    // If priority decreases, delete and reinsert
+    // If priority decreases, the children move up in its place and the
+    // node is melded back on its own
     if (comp_(value, newValue)) {
-      eraseOne(theNode);
-      return push(newValue);
+      PairingHeapNode<T> *children = theNode->child;
+      theNode->child = nullptr;
+      if (theNode == root_) {
+        root_ = mergePairs(children);
+      } else {
+        detachNode(theNode);
+        root_ = meld(root_, mergePairs(children));
+      }
+      root_ = meld(root_, theNode);
+      return theNode;
     }
 
-    theNode->value = newValue;
-
     // No restructuring needed if priority did not increase
     if (!comp_(newValue, value)) {
       return theNode;
@@ -138,6 +227,8 @@ public:
       pop();
       return true;
     }
+    if constexpr (kIndexed)
+      index_.erase(keyOf_(theNode->value));
     PairingHeapNode<T> *childPointer = theNode->child;
     detachNode(theNode);
     while (childPointer) {
@@ -165,36 +256,11 @@ public:
       throw std::runtime_error("PairingHeap is empty");
 
     T value = root_->value;
-    PairingHeapNode<T> *childPointer = root_->child;
-    std::vector<PairingHeapNode<T> *> meldStack;
-    // Two pass merging of children
-    while (childPointer && childPointer->rightSibling) {
-      PairingHeapNode<T> *first = childPointer;
-      PairingHeapNode<T> *second = childPointer->rightSibling;
-      childPointer = second->rightSibling;
-      meldStack.push_back(meld(first, second));
-    }
-
-    if (childPointer) {
-      if (!meldStack.empty()) {
-        PairingHeapNode<T> *temp = meldStack.back();
-        meldStack.pop_back();
-        meldStack.push_back(meld(temp, childPointer));
-      } else
-        meldStack.push_back(childPointer);
-    }
-
-    PairingHeapNode<T> *second = nullptr;
-    while (!meldStack.empty()) {
-      PairingHeapNode<T> *first = meldStack.back();
-      meldStack.pop_back();
-      second = meld(first, second);
-    }
+    if constexpr (kIndexed)
+      index_.erase(keyOf_(value));
+    PairingHeapNode<T> *children = root_->child;
     delete root_;
-    root_ = second;
-    if (root_) {
-      root_->rightSibling = root_->leftSibling = nullptr;
-    }
+    root_ = mergePairs(children);
     totalNodes--;
     return value;
   }
@@ -207,6 +273,8 @@ public:
 
   // Removes all elements from the heap
   void clear() noexcept {
+    if constexpr (kIndexed)
+      index_.clear();
     if (!root_)
       return;
     std::vector<PairingHeapNode<T> *> stk{root_};
@@ -221,20 +289,38 @@ public:
     totalNodes = 0;
   }
 
+  // Returns the node of the element with the given key, nullptr if absent
+  template <typename Key>
+    requires kIndexed
+  PairingHeapNode<T> *find(const Key &key) const {
+    auto entry = index_.find(key);
+    return entry == index_.end() ? nullptr : entry->second;
+  }
+
   // Searches for a node with the given value
+  // Indexed heaps look the value up by key, others walk the whole tree
   PairingHeapNode<T> *findNode(const T &value) {
-    if (!root_)
+    if constexpr (kIndexed) {
+      PairingHeapNode<T> *theNode = find(keyOf_(value));
+      if constexpr (std::equality_comparable<T>) {
+        if (theNode && !(theNode->value == value))
+          return nullptr;
+      }
+      return theNode;
+    } else {
+      if (!root_)
+        return nullptr;
+      std::vector<PairingHeapNode<T> *> stk{root_};
+      while (!stk.empty()) {
+        PairingHeapNode<T> *n = stk.back();
+        stk.pop_back();
+        if (n->value == value)
+          return n;
+        for (PairingHeapNode<T> *c = n->child; c; c = c->rightSibling)
+          stk.push_back(c);
+      }
       return nullptr;
-    std::vector<PairingHeapNode<T> *> stk{root_};
-    while (!stk.empty()) {
-      PairingHeapNode<T> *n = stk.back();
-      stk.pop_back();
-      if (n->value == value)
-        return n;
-      for (PairingHeapNode<T> *c = n->child; c; c = c->rightSibling)
-        stk.push_back(c);
     }
-    return nullptr;
   }
 
   PairingHeap(const PairingHeap &) = delete;
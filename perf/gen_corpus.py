@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Generate the fixed perf-check corpus of scheduler command files.
+
+The corpus is committed under perf/corpus/ together with reference outputs,
+so this script only needs rerunning when a scenario is added or changed.
+"""
+import os
+import random
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+# name -> (seed, commands, runways, max duration, max time step, max priority)
+SCENARIOS = {
+    "light": (11, 12000, 4, 6, 3, 15),
+    "mixed": (12, 8000, 2, 20, 3, 15),
+    "congested": (13, 2500, 1, 40, 2, 15),
+    "wide_priority": (14, 6000, 3, 25, 3, 40),
+}
+
+
+def generate(seed, commands, runways, max_duration, max_step, max_priority):
+    rng = random.Random(seed)
+    lines = [f"Initialize({runways})"]
+    time = 0
+    next_id = 0
+    submitted = []
+    for _ in range(commands):
+        time += rng.randint(0, max_step)
+        roll = rng.random()
+        if roll < 0.55:
+            next_id += rng.choice([1, 1, 1, 2])
+            flight = next_id
+            if submitted and rng.random() < 0.03:
+                flight = rng.choice(submitted)  # duplicate ID
+            submitted.append(next_id)
+            lines.append(
+                f"SubmitFlight({flight}, {rng.randint(1, 20)}, {time}, "
+                f"{rng.randint(0, max_priority)}, {rng.randint(1, max_duration)})"
+            )
+        elif roll < 0.63 and submitted:
+            lines.append(f"CancelFlight({rng.choice(submitted)}, {time})")
+        elif roll < 0.71 and submitted:
+            lines.append(
+                f"Reprioritize({rng.choice(submitted)}, {time}, "
+                f"{rng.randint(0, max_priority)})"
+            )
+        elif roll < 0.73:
+            lines.append(f"AddRunways({rng.randint(0, 2)}, {time})")
+        elif roll < 0.77:
+            low = rng.randint(1, 20)
+            lines.append(f"GroundHold({low}, {low + rng.randint(-1, 2)}, {time})")
+        elif roll < 0.87:
+            lines.append(f"Tick({time})")
+        elif roll < 0.93:
+            lines.append(f"PrintSchedule({time}, {time + rng.randint(0, 30)})")
+        else:
+            lines.append("PrintActive()")
+    lines.append("Quit()")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    corpus = os.path.join(HERE, "corpus")
+    os.makedirs(corpus, exist_ok=True)
+    for name, params in SCENARIOS.items():
+        with open(os.path.join(corpus, name + ".txt"), "w") as f:
+            f.write(generate(*params))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""Performance regression gate for the scheduler (make perf-check).
+
+Replays every command file in perf/corpus/ through a release binary built
+with -DGATOR_COUNT_ALLOCATIONS and
+  * diffs each <name>_output_file.txt byte-for-byte against
+    perf/reference/<name>_output_file.txt,
+  * compares the allocation count against perf/baselines.txt and the best
+    wall time of --runs runs against perf/host_baselines.txt, failing on
+    regressions above the thresholds.
+
+Allocation counts do not depend on the host, so perf/baselines.txt is
+tracked. Wall times only compare on the machine that measured them, so
+perf/host_baselines.txt is untracked; without it the wall time is reported
+but not gated.
+
+--update-host-baselines rewrites host_baselines.txt from this machine's
+wall times. --update-allocations rewrites baselines.txt; only use it when
+an allocation change is intended. --freeze-references rewrites the
+reference outputs; only use it when an output change is intended.
+"""
+import argparse
+import filecmp
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+CORPUS = os.path.join(HERE, "corpus")
+REFERENCE = os.path.join(HERE, "reference")
+ALLOCATIONS = os.path.join(HERE, "baselines.txt")
+HOST_BASELINES = os.path.join(HERE, "host_baselines.txt")
+
+
+def run_scenario(binary, source, workdir, runs):
+    """Return (best wall seconds, allocation count, output path)."""
+    name = os.path.basename(source)
+    scenario = os.path.join(workdir, name)
+    shutil.copyfile(source, scenario)
+    output = os.path.splitext(scenario)[0] + "_output_file.txt"
+    best = None
+    allocations = None
+    for _ in range(runs):
+        start = time.perf_counter()
+        result = subprocess.run(
+            [binary, scenario], stderr=subprocess.PIPE, text=True
+        )
+        elapsed = time.perf_counter() - start
+        if result.returncode != 0:
+            sys.exit(f"{name}: scheduler exited with {result.returncode}\n"
+                     + result.stderr)
+        match = re.search(r"allocations: (\d+)", result.stderr)
+        if not match:
+            sys.exit(f"{name}: no allocation count on stderr, "
+                     "build with -DGATOR_COUNT_ALLOCATIONS")
+        allocations = int(match.group(1))
+        best = elapsed if best is None else min(best, elapsed)
+    return best, allocations, output
+
+
+def read_baselines(path, parse):
+    """Return {scenario: parse(value)} from a "scenario value" file."""
+    baselines = {}
+    if not os.path.exists(path):
+        return baselines
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if fields and not fields[0].startswith("#"):
+                baselines[fields[0]] = parse(fields[1])
+    return baselines
+
+
+def write_baselines(path, header, values):
+    with open(path, "w") as f:
+        f.write(f"# scenario  {header}\n")
+        for name, value in sorted(values.items()):
+            f.write(f"{name} {value}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("binary")
+    parser.add_argument("--runs", type=int, default=7)
+    parser.add_argument("--threshold", type=float, default=25.0,
+                        help="allowed wall time regression in percent")
+    parser.add_argument("--alloc-threshold", type=float, default=1.0,
+                        help="allowed allocation count regression in percent")
+    parser.add_argument("--host-baselines", default=HOST_BASELINES,
+                        help="wall time baselines of this host and build")
+    parser.add_argument("--update-host-baselines", action="store_true")
+    parser.add_argument("--update-allocations", action="store_true")
+    parser.add_argument("--freeze-references", action="store_true")
+    args = parser.parse_args()
+
+    binary = os.path.abspath(args.binary)
+    scenarios = sorted(f for f in os.listdir(CORPUS) if f.endswith(".txt"))
+    host_walls = read_baselines(args.host_baselines, float)
+    base_allocations = read_baselines(ALLOCATIONS, int)
+    measured_walls = {}
+    measured_allocations = {}
+    failures = []
+
+    with tempfile.TemporaryDirectory() as workdir:
+        for scenario in scenarios:
+            name = os.path.splitext(scenario)[0]
+            wall, allocations, output = run_scenario(
+                binary, os.path.join(CORPUS, scenario), workdir, args.runs)
+            wall_ms = wall * 1000
+            measured_walls[name] = f"{wall_ms:.2f}"
+            measured_allocations[name] = allocations
+
+            reference = os.path.join(REFERENCE, name + "_output_file.txt")
+            if args.freeze_references:
+                os.makedirs(REFERENCE, exist_ok=True)
+                shutil.copyfile(output, reference)
+            elif not os.path.exists(reference):
+                failures.append(f"{name}: missing reference output")
+            elif not filecmp.cmp(output, reference, shallow=False):
+                failures.append(f"{name}: output differs from reference")
+
+            line = f"{name:16} {wall_ms:9.2f} ms {allocations:12d} allocs"
+            if name in host_walls and not args.update_host_baselines:
+                wall_change = (wall_ms / host_walls[name] - 1) * 100
+                line += f"   {wall_change:+6.1f}% time"
+                if wall_change > args.threshold:
+                    failures.append(f"{name}: wall time {wall_change:+.1f}% "
+                                    f"exceeds {args.threshold}%")
+            else:
+                line += "   (no host baseline)"
+            if name in base_allocations and not args.update_allocations:
+                alloc_change = (allocations /
+                                max(base_allocations[name], 1) - 1) * 100
+                line += f"   {alloc_change:+6.1f}% allocs"
+                if alloc_change > args.alloc_threshold:
+                    failures.append(f"{name}: allocations {alloc_change:+.1f}% "
+                                    f"exceed {args.alloc_threshold}%")
+            elif not args.update_allocations:
+                line += "   (no allocation baseline)"
+            print(line)
+
+    if args.update_host_baselines:
+        write_baselines(args.host_baselines, "best_wall_ms", measured_walls)
+        print("Host baselines written to "
+              f"{os.path.relpath(args.host_baselines)}")
+    elif not host_walls:
+        print("Wall time not gated, run make perf-baseline on this host")
+    if args.update_allocations:
+        write_baselines(ALLOCATIONS, "allocations", measured_allocations)
+        print(f"Allocations written to {os.path.relpath(ALLOCATIONS)}")
+    for failure in failures:
+        print("FAIL " + failure)
+    if failures:
+        sys.exit(1)
+    print("perf-check passed")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,305 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware events sampled around scheduler phases
+enum PerfEvent {
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_L1D_MISSES,
+  PERF_LLC_MISSES,
+  PERF_BRANCH_MISSES,
+  PERF_EVENT_COUNT
+};
+
+// Counter values at one point in time, or the difference of two readings
+// timeEnabled and timeRunning are the nanoseconds the group was enabled and
+// actually counting; they differ when the kernel multiplexes counters
+struct PerfSample {
+  std::array<std::uint64_t, PERF_EVENT_COUNT> values{};
+  std::uint64_t timeEnabled{0};
+  std::uint64_t timeRunning{0};
+
+  PerfSample operator-(const PerfSample &other) const {
+    PerfSample delta;
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+      delta.values[i] = values[i] - other.values[i];
+    delta.timeEnabled = timeEnabled - other.timeEnabled;
+    delta.timeRunning = timeRunning - other.timeRunning;
+    return delta;
+  }
+
+  PerfSample &operator+=(const PerfSample &other) {
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+      values[i] += other.values[i];
+    timeEnabled += other.timeEnabled;
+    timeRunning += other.timeRunning;
+    return *this;
+  }
+
+  // Values extrapolated to the whole enabled time of a multiplexed group
+  // A sample that never ran is returned as is, all of its values are zero
+  PerfSample scaled() const {
+    PerfSample result = *this;
+    if (timeRunning == 0 || timeRunning == timeEnabled)
+      return result;
+    double scale =
+        static_cast<double>(timeEnabled) / static_cast<double>(timeRunning);
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+      result.values[i] =
+          static_cast<std::uint64_t>(static_cast<double>(values[i]) * scale);
+    return result;
+  }
+};
+
+// User-space hardware counters of the calling thread, opened as one
+// perf_event_open group so a reading is a single read() of all events.
+// Events the CPU or kernel does not offer are left out of the group.
+class PerfCounters {
+private:
+  int leader_{-1};
+  std::array<int, PERF_EVENT_COUNT> fds_{};
+  std::array<bool, PERF_EVENT_COUNT> available_{};
+  // Events in group order, the order read() reports them in
+  std::array<int, PERF_EVENT_COUNT> order_{};
+  int opened_{0};
+
+#ifdef __linux__
+  static perf_event_attr attributes(int event) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch (event) {
+    case PERF_CYCLES:
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case PERF_INSTRUCTIONS:
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case PERF_L1D_MISSES:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_L1D |
+                    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      break;
+    case PERF_LLC_MISSES:
+      attr.config = PERF_COUNT_HW_CACHE_MISSES;
+      break;
+    case PERF_BRANCH_MISSES:
+      attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+    }
+    return attr;
+  }
+#endif
+
+public:
+  PerfCounters() { fds_.fill(-1); }
+
+  // Opens every event it can, returns false with a reason if none opened
+  bool open(std::string &error) {
+#ifdef __linux__
+    for (int event = 0; event < PERF_EVENT_COUNT; event++) {
+      perf_event_attr attr = attributes(event);
+      int fd = static_cast<int>(
+          syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0));
+      if (fd < 0) {
+        if (error.empty())
+          error = std::strerror(errno);
+        continue;
+      }
+      if (leader_ < 0)
+        leader_ = fd;
+      fds_[event] = fd;
+      available_[event] = true;
+      order_[opened_++] = event;
+    }
+    if (leader_ < 0)
+      return false;
+    ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+#else
+    error = "perf_event_open is Linux only";
+    return false;
+#endif
+  }
+
+  bool available(int event) const { return available_[event]; }
+
+  // Current raw counter values, zero for unavailable events
+  PerfSample read() const {
+    PerfSample sample;
+#ifdef __linux__
+    if (leader_ < 0)
+      return sample;
+    // Group read format: event count, time enabled, time running, then one
+    // value per event
+    std::uint64_t buffer[PERF_EVENT_COUNT + 3];
+    if (::read(leader_, buffer, sizeof(buffer)) <= 0)
+      return sample;
+    std::uint64_t count = std::min<std::uint64_t>(buffer[0], opened_);
+    sample.timeEnabled = buffer[1];
+    sample.timeRunning = buffer[2];
+    for (std::uint64_t i = 0; i < count; i++)
+      sample.values[order_[i]] = buffer[i + 3];
+#endif
+    return sample;
+  }
+
+  ~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds_)
+      if (fd >= 0)
+        close(fd);
+#endif
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+};
+
+// Per-phase totals of counter deltas, reported by dump()
+class PerfStats {
+private:
+  struct PhaseTotals {
+    // Scaled per call, timeRunning stays 0 if the group never counted
+    PerfSample counts;
+    std::uint64_t calls{0};
+    // Sum of the flights in the system at each call, the work the phase
+    // had in front of it
+    std::uint64_t flights{0};
+  };
+
+  PerfCounters counters_;
+  std::map<std::string, PhaseTotals> phases_;
+
+  static void ratio(std::ostream &os, std::uint64_t count, std::uint64_t of,
+                    bool available) {
+    os << std::setw(12);
+    if (!available || of == 0)
+      os << "n/a";
+    else
+      os << static_cast<double>(count) / static_cast<double>(of);
+  }
+
+public:
+  // Opens the counters, explaining on log why stats stay off if they cannot
+  bool open(std::ostream &log) {
+    std::string error;
+    if (counters_.open(error))
+      return true;
+    log << "Performance counters unavailable (" << error
+        << "), --perf-stats disabled" << "\n";
+    return false;
+  }
+
+  PerfSample sample() const { return counters_.read(); }
+
+  // Adds the counts between two readings to a phase
+  void record(const char *phase, const PerfSample &start,
+              const PerfSample &end, std::uint64_t flights) {
+    PhaseTotals &totals = phases_[phase];
+    totals.counts += (end - start).scaled();
+    totals.calls++;
+    totals.flights += flights;
+  }
+
+  // Prints IPC and misses per flight of every phase
+  // Counter columns are n/a for a phase the kernel never scheduled the
+  // group in, since its counts would all read zero
+  void dump(std::ostream &os) const {
+    os << std::left << std::setw(20) << "phase" << std::right
+       << std::setw(10) << "calls" << std::setw(14) << "flights"
+       << std::setw(16) << "cycles" << std::setw(8) << "IPC"
+       << std::setw(12) << "L1D/flight" << std::setw(12) << "LLC/flight"
+       << std::setw(12) << "br/flight" << "\n";
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    os << std::fixed << std::setprecision(2);
+    for (const auto &[name, totals] : phases_) {
+      const auto &v = totals.counts.values;
+      bool counted = totals.counts.timeRunning > 0;
+      auto available = [&](int event) {
+        return counted && counters_.available(event);
+      };
+      os << std::left << std::setw(20) << name << std::right
+         << std::setw(10) << totals.calls << std::setw(14) << totals.flights
+         << std::setw(16);
+      if (available(PERF_CYCLES))
+        os << v[PERF_CYCLES];
+      else
+        os << "n/a";
+      os << std::setw(8);
+      if (available(PERF_CYCLES) && available(PERF_INSTRUCTIONS) &&
+          v[PERF_CYCLES] > 0)
+        os << static_cast<double>(v[PERF_INSTRUCTIONS]) / v[PERF_CYCLES];
+      else
+        os << "n/a";
+      ratio(os, v[PERF_L1D_MISSES], totals.flights,
+            available(PERF_L1D_MISSES));
+      ratio(os, v[PERF_LLC_MISSES], totals.flights,
+            available(PERF_LLC_MISSES));
+      ratio(os, v[PERF_BRANCH_MISSES], totals.flights,
+            available(PERF_BRANCH_MISSES));
+      os << "\n";
+    }
+    os.flags(flags);
+    os.precision(precision);
+  }
+};
+
+// Attributes the counts of a scope to a named phase
+// next() closes the current phase and opens another with one reading
+// A null stats pointer makes every operation a no-op
+class PerfPhase {
+private:
+  PerfStats *stats_;
+  const char *name_;
+  std::uint64_t flights_;
+  PerfSample start_;
+
+public:
+  PerfPhase(PerfStats *stats, const char *name, std::uint64_t flights)
+      : stats_(stats), name_(name), flights_(flights) {
+    if (stats_)
+      start_ = stats_->sample();
+  }
+
+  void next(const char *name, std::uint64_t flights) {
+    if (!stats_)
+      return;
+    PerfSample now = stats_->sample();
+    stats_->record(name_, start_, now, flights_);
+    name_ = name;
+    flights_ = flights;
+    start_ = now;
+  }
+
+  ~PerfPhase() {
+    if (stats_)
+      stats_->record(name_, start_, stats_->sample(), flights_);
+  }
+
+  PerfPhase(const PerfPhase &) = delete;
+  PerfPhase &operator=(const PerfPhase &) = delete;
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <concepts>
+#include <cstddef>
+
+// Minimal interface shared by every priority queue the scheduler uses
+template <typename Q>
+concept PriorityQueue = requires(Q q, const Q cq,
+                                 const typename Q::value_type &value) {
+  typename Q::value_type;
+  typename Q::size_type;
+  q.push(value);
+  { q.pop() } -> std::convertible_to<typename Q::value_type>;
+  { q.top() } -> std::convertible_to<typename Q::value_type>;
+  { cq.empty() } -> std::convertible_to<bool>;
+  { cq.size() } -> std::convertible_to<std::size_t>;
+  q.clear();
+};
+
+// Priority queue that can remove an element by value (completion timetable)
+template <typename Q>
+concept ErasablePriorityQueue =
+    PriorityQueue<Q> && requires(Q q, typename Q::value_type value) {
+      { q.eraseOne(value) } -> std::convertible_to<bool>;
+    };
+
+// Priority queue handing out stable handles for erase and changeKey
+// (pending flights queue)
+template <typename Q>
+concept AddressablePriorityQueue =
+    PriorityQueue<Q> && requires(Q q, typename Q::handle_type handle,
+                                 const typename Q::value_type &value) {
+      typename Q::handle_type;
+      { q.push(value) } -> std::same_as<typename Q::handle_type>;
+      { q.changeKey(handle, value) } -> std::same_as<typename Q::handle_type>;
+      { q.eraseOne(handle) } -> std::convertible_to<bool>;
+      { handle->value } -> std::convertible_to<typename Q::value_type>;
+    };
+
+// Queue whose pops are cheapest when pushes arrive in comparison order, like
+// BucketQueue levels that are sorted again after an out-of-order push
+template <typename Q>
+concept PrefersOrderedPushes = requires { requires Q::kPrefersOrderedPushes; };
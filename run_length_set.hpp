@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <map>
+
+// Set of integers stored as maximal runs of consecutive values
+// Dense ID ranges (e.g. flights completing roughly in ID order) collapse
+// into a handful of runs instead of one entry per ID
+class RunLengthSet {
+private:
+  // First value of each run -> last value (inclusive), runs never touch
+  std::map<int, int> runs_{};
+  std::size_t count_{0};
+
+  // Whether b directly follows a
+  static bool adjacent(int a, int b) {
+    return static_cast<long long>(a) + 1 == static_cast<long long>(b);
+  }
+
+public:
+  using size_type = std::size_t;
+
+  // Returns true if the value is in the set
+  bool contains(int value) const {
+    auto next = runs_.upper_bound(value);
+    if (next == runs_.begin())
+      return false;
+    return value <= std::prev(next)->second;
+  }
+
+  // Adds a value, merging it with neighbouring runs
+  // Returns false if it was already present
+  bool insert(int value) {
+    auto next = runs_.upper_bound(value);
+    if (next != runs_.begin()) {
+      auto prev = std::prev(next);
+      if (value <= prev->second)
+        return false;
+      if (adjacent(prev->second, value)) {
+        prev->second = value;
+        if (next != runs_.end() && adjacent(value, next->first)) {
+          prev->second = next->second;
+          runs_.erase(next);
+        }
+        count_++;
+        return true;
+      }
+    }
+    if (next != runs_.end() && adjacent(value, next->first)) {
+      int last = next->second;
+      runs_.erase(next);
+      runs_.emplace(value, last);
+    } else {
+      runs_.emplace(value, value);
+    }
+    count_++;
+    return true;
+  }
+
+  void clear() noexcept {
+    runs_.clear();
+    count_ = 0;
+  }
+
+  // Number of values in the set
+  size_type size() const noexcept { return count_; }
+
+  // Number of stored runs, the actual memory footprint
+  size_type runs() const noexcept { return runs_.size(); }
+
+  bool empty() const noexcept { return count_ == 0; }
+};
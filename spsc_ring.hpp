@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Bounded single-producer single-consumer ring buffer
+// One thread may push and one other thread may pop. Each side keeps a cached
+// copy of the other side's index and only reloads it when the ring looks
+// full or empty. A blocked side sleeps on the index it waits for (C++20
+// atomic wait) after a short spin.
+template <typename T> class SpscRing {
+private:
+  static constexpr int kSpins = 64;
+
+  std::vector<T> slots_;
+  std::size_t mask_;
+
+  // Consumer side: next slot to pop, and the producer index last seen
+  alignas(64) std::atomic<std::size_t> head_{0};
+  std::size_t cachedTail_{0};
+
+  // Producer side: next slot to push, and the consumer index last seen
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  std::size_t cachedHead_{0};
+
+  // Waits until index moves away from seen, returns its new value
+  static std::size_t waitChange(const std::atomic<std::size_t> &index,
+                                std::size_t seen) {
+    for (int spin = 0; spin < kSpins; spin++) {
+      std::size_t now = index.load(std::memory_order_acquire);
+      if (now != seen)
+        return now;
+    }
+    index.wait(seen, std::memory_order_acquire);
+    return index.load(std::memory_order_acquire);
+  }
+
+public:
+  // Capacity must be a power of two
+  explicit SpscRing(std::size_t capacity)
+      : slots_(capacity), mask_(capacity - 1) {
+    if (capacity == 0 || (capacity & mask_) != 0)
+      throw std::invalid_argument("SpscRing capacity must be a power of two");
+  }
+
+  // Producer: appends a value, blocking while the ring is full
+  void push(T value) {
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    while (tail - cachedHead_ == slots_.size())
+      cachedHead_ = waitChange(head_, cachedHead_);
+    slots_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    tail_.notify_one();
+  }
+
+  // Consumer: removes the oldest value, blocking while the ring is empty
+  T pop() {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    while (head == cachedTail_)
+      cachedTail_ = waitChange(tail_, cachedTail_);
+    T value = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    head_.notify_one();
+    return value;
+  }
+
+  std::size_t capacity() const noexcept { return slots_.size(); }
+
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Fixed-size thread pool running tasks in submission order
+class ThreadPool {
+private:
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  bool stopping_{false};
+
+  // Worker loop: run tasks until the pool is stopped and drained
+  void work() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+        if (tasks_.empty())
+          return;
+        task = std::move(tasks_.front());
+        tasks_.pop();
+      }
+      task();
+    }
+  }
+
+public:
+  // Starts threadCount workers (at least one)
+  explicit ThreadPool(std::size_t threadCount) {
+    if (threadCount == 0)
+      threadCount = 1;
+    for (std::size_t i = 0; i < threadCount; i++)
+      workers_.emplace_back([this] { work(); });
+  }
+
+  // Queues a callable and returns a future for its result
+  template <typename F> auto submit(F task) {
+    using R = std::invoke_result_t<F>;
+    auto packaged = std::make_shared<std::packaged_task<R()>>(std::move(task));
+    std::future<R> result = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace([packaged] { (*packaged)(); });
+    }
+    ready_.notify_one();
+    return result;
+  }
+
+  std::size_t size() const noexcept { return workers_.size(); }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    ready_.notify_all();
+    for (std::thread &worker : workers_)
+      worker.join();
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+};